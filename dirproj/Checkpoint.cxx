@@ -0,0 +1,455 @@
+/**
+ *
+ * @File : Checkpoint.cxx
+ *
+ * @Synopsis : sauvegarde et restauration de la simulation (voir Checkpoint.h)
+ *
+ **/
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <sstream>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <signal.h>
+
+#include "Checkpoint.h"
+#include "nsSysteme.h"
+
+using namespace std;
+using namespace nsSysteme;
+
+namespace ProcDebug {
+
+    namespace {
+        const char         checkpointMagic[] = "PDC1";
+        const unsigned int magicLength       = 4;
+        // garde-fou contre un fichier corrompu : pas plus de cases
+        // (memoire partagee ou tas d'un processus) que ceci
+        const unsigned long maxCells         = 1UL << 26;
+    }
+
+    void Checkpoint::putString(const string &str) {
+        putVarint(str . size());
+        out . insert(out . end(), str . begin(), str . end());
+    }
+
+    // par plages : (longueur, valeur)
+
+    void Checkpoint::putCells(const vector<int> &cells) {
+        putVarint(cells . size());
+        for(unsigned int k = 0; k < cells . size(); ) {
+            unsigned int next (k + 1);
+            while(next < cells . size() && cells[next] == cells[k]) ++next;
+            putVarint(next - k);
+            putInt(cells[k]);
+            k = next;
+        }
+    }
+
+    void Checkpoint::putTree(const ProcInfo::ProcInstruction *instr) {
+        if(instr == 0) return;
+        putInt(instr -> programCounter);
+        putVarint(instr -> condEval);
+        for(unsigned int k = 0; k < instr -> bodyInstr . size(); ++k) {
+            putTree(instr -> bodyInstr[k]);
+        }
+    }
+
+    unsigned long Checkpoint::getVarint() {
+        unsigned long v (0);
+        for(unsigned int shift = 0; in < inEnd && shift < 64; shift += 7) {
+            const unsigned char c (*in++);
+            v |= static_cast<unsigned long>(c & 0x7F) << shift;
+            if(!(c & 0x80)) return v;
+        }
+        throw CExc("Checkpoint::restore()", fileName + " tronque");
+    }
+
+    string Checkpoint::getString() {
+        const unsigned long length (getVarint());
+        if(length > static_cast<unsigned long>(inEnd - in)) {
+            throw CExc("Checkpoint::restore()", fileName + " tronque");
+        }
+        const string str (reinterpret_cast<const char *>(in), length);
+        in += length;
+        return str;
+    }
+
+    void Checkpoint::getCells(vector<int> *pCells) {
+        const unsigned long nbCells (getVarint());
+        if(nbCells > maxCells) {
+            throw CExc("Checkpoint::restore()",
+                       fileName + " : memoire trop grande");
+        }
+        pCells -> clear();
+        pCells -> reserve(nbCells);
+        while(pCells -> size() < nbCells) {
+            const unsigned long length (getVarint());
+            const int           value  (getInt());
+            if(length == 0 || length > nbCells - pCells -> size()) {
+                throw CExc("Checkpoint::restore()",
+                           fileName + " : plage de memoire invalide");
+            }
+            pCells -> insert(pCells -> end(), length, value);
+        }
+    }
+
+    void Checkpoint::getTree(ProcInfo::ProcInstruction *instr) {
+        if(instr == 0) return;
+        const int          pc       (getInt());
+        const unsigned int condEval (getVarint());
+        if(pc < -1 || pc >= static_cast<int>(instr -> bodyInstr . size()) ||
+           condEval > ProcInfo::COND_EVAL_FALSE) {
+            throw CExc("Checkpoint::restore()",
+                       fileName + " : compteur ordinal invalide");
+        }
+        instr -> programCounter = pc;
+        instr -> condEval       = static_cast<ProcInfo::ProcCondEval>(condEval);
+        for(unsigned int k = 0; k < instr -> bodyInstr . size(); ++k) {
+            getTree(instr -> bodyInstr[k]);
+        }
+    }
+
+    int Checkpoint::getPid(const unsigned long nbPid) {
+        const unsigned long procPid (getVarint());
+        if(procPid >= nbPid) {
+            throw CExc("Checkpoint::restore()", fileName + " : pid invalide");
+        }
+        return procPid;
+    }
+
+    // un nombre d'elements, borne avant qu'on n'alloue quoi que ce soit :
+    // un fichier abime donne une CExc, pas un bad_alloc
+
+    unsigned long Checkpoint::getCount(const unsigned long maxCount) {
+        const unsigned long count (getVarint());
+        if(count > maxCount) {
+            throw CExc("Checkpoint::restore()", fileName + " tronque");
+        }
+        return count;
+    }
+
+    void Checkpoint::checkCount(const unsigned long expected,
+                                const char *what) {
+        if(getVarint() != expected) {
+            throw CExc("Checkpoint::restore()",
+                       fileName + " : pas le meme nombre de " + what
+                       + " que les programmes charges");
+        }
+    }
+
+    void Checkpoint::save(const ProcInfo &pInfo, const string &fileName) {
+        Checkpoint ckpt (fileName);
+        ckpt . out . insert(ckpt . out . end(), checkpointMagic,
+                            checkpointMagic + magicLength);
+
+        const vector<ProcInfo::ProcData *> & procData (pInfo . procData);
+        ckpt . putVarint(procData . size());
+        ckpt . putVarint(pInfo . procExit . size());
+        for(unsigned int k = 0; k < pInfo . procExit . size(); ++k) {
+            ckpt . putVarint(pInfo . procExit[k] . generation);
+            ckpt . putVarint(pInfo . procExit[k] . exitCode);
+        }
+        ckpt . putVarint(pInfo . reapedCount);
+        ckpt . putVarint(pInfo . freePids . size());
+        for(unsigned int k = 0; k < pInfo . freePids . size(); ++k) {
+            ckpt . putVarint(pInfo . freePids[k]);
+        }
+        ckpt . putVarint(pInfo . zombiePids . size());
+        for(unsigned int k = 0; k < pInfo . zombiePids . size(); ++k) {
+            ckpt . putVarint(pInfo . zombiePids[k]);
+        }
+        ckpt . putInt(pInfo . outstandingProcCount);
+        ckpt . putInt(pInfo . mutex);
+        ckpt . putInt(pInfo . mutexOwner);
+        ckpt . putInt(pInfo . sharedMemoryBase);
+        ckpt . putInt(pInfo . sharedMemoryLimit);
+        ckpt . putCells(pInfo . sharedMemory);
+
+        for(unsigned int kProc = 0; kProc < procData . size(); ++kProc) {
+            const ProcInfo::ProcData * pData (procData[kProc]);
+            if(pData == 0) {
+                ckpt . putVarint(0);
+                continue;
+            }
+            ckpt . putVarint(1);
+            ckpt . putString(pData -> progName);
+            // trace, elu, en pleine entree/sortie... : en attente
+            ckpt . putVarint(pData -> procStatus == ProcInfo::STAT_TERMINATED);
+            ckpt . putVarint(pData -> procMutexStatus);
+            ckpt . putInt   (pData -> nextLineNumber);
+            ckpt . putVarint(pData -> qReapable);
+            ckpt . putVarint(pData -> exitCode);
+            vector<int> sigs;
+            for(int sig = 1; sig < CstSigMax; ++sig) {
+                if(Sigismember(&pData -> sigMask, sig)) sigs . push_back(sig);
+            }
+            ckpt . putVarint(sigs . size());
+            for(unsigned int k = 0; k < sigs . size(); ++k) {
+                ckpt . putVarint(sigs[k]);
+            }
+            ckpt . putVarint(pData -> symbolTable . size());
+            for(unsigned int k = 0; k < pData -> symbolTable . size(); ++k) {
+                ckpt . putInt(pData -> symbolTable[k] . value);
+            }
+            ckpt . putInt  (pData -> heapMemoryLimit);
+            ckpt . putCells(pData -> heapMemory);
+            ckpt . putVarint(ProcInfo::countInstructions(pData -> proGram));
+            ckpt . putTree  (pData -> proGram);
+            ckpt . putVarint(ProcInfo::countInstructions(pData -> hanDler));
+            ckpt . putTree  (pData -> hanDler);
+        }
+
+        // un processus elu mais pas encore avance (le debugger a ete
+        // appele entre les deux) n'est dans aucune file : on l'y remet
+        const Scheduler & sched (*pInfo . scheduler);
+        vector<deque<int> > queues (sched . waitQueue);
+        vector<bool>        qQueued (procData . size(), false);
+        for(unsigned int kCpu = 0; kCpu < queues . size(); ++kCpu) {
+            for(unsigned int k = 0; k < queues[kCpu] . size(); ++k) {
+                qQueued[queues[kCpu][k]] = true;
+            }
+        }
+        for(unsigned int kProc = 0; kProc < procData . size(); ++kProc) {
+            if(procData[kProc] && !qQueued[kProc] &&
+               procData[kProc] -> procStatus != ProcInfo::STAT_TERMINATED) {
+                queues[0] . push_back(kProc);
+            }
+        }
+        ckpt . putVarint(queues . size());
+        for(unsigned int kCpu = 0; kCpu < queues . size(); ++kCpu) {
+            ckpt . putVarint(queues[kCpu] . size());
+            for(unsigned int k = 0; k < queues[kCpu] . size(); ++k) {
+                ckpt . putVarint(queues[kCpu][k]);
+            }
+            ckpt . putVarint(sched . cpuStat[kCpu] . busyTicks);
+            ckpt . putVarint(sched . cpuStat[kCpu] . idleTicks);
+            ckpt . putVarint(sched . cpuStat[kCpu] . steals);
+        }
+        ckpt . putVarint(sched . tickCount);
+        ckpt . putVarint(sched . procAffinity . size());
+        for(unsigned int k = 0; k < sched . procAffinity . size(); ++k) {
+            ckpt . putInt   (sched . procAffinity[k] . cpu);
+            ckpt . putVarint(sched . procAffinity[k] . migrations);
+            ckpt . putVarint(sched . procAffinity[k] . lastTick);
+        }
+        ckpt . putVarint(sched . stepsSinceProgress);
+        ckpt . putInt   (sched . mutexWaitCount);
+
+        const int fd (Open(fileName . c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+                           0644));
+        for(size_t done = 0; done < ckpt . out . size(); ) {
+            done += Write(fd, &ckpt . out[done], ckpt . out . size() - done);
+        }
+        Close(fd);
+    } // save()
+
+    void Checkpoint::restore(ProcInfo *pInfo, const string &fileName) {
+        Checkpoint ckpt (fileName);
+        struct stat fileStat;
+        Stat(fileName . c_str(), &fileStat);
+        if(fileStat . st_size < static_cast<off_t>(magicLength)) {
+            throw CExc("Checkpoint::restore()",
+                       fileName + " n'est pas un checkpoint");
+        }
+        const size_t length (fileStat . st_size);
+        const int    fd     (Open(fileName . c_str(), O_RDONLY));
+        void *       mapped (0);
+        try {
+            mapped = Mmap(0, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        catch (...) {
+            Close(fd);
+            throw;
+        }
+        Close(fd); // la projection reste valide
+
+        // les programmes charges servent de modeles aux processus relus
+        map<string, const ProcInfo::ProcData *> models;
+        for(unsigned int kProc = 0; kProc < pInfo -> procData . size();
+            ++kProc) {
+            const ProcInfo::ProcData * pData (pInfo -> procData[kProc]);
+            if(pData && !pData -> qReapable &&
+               !models . count(pData -> progName)) {
+                models[pData -> progName] = pData;
+            }
+        }
+
+        vector<ProcInfo::ProcData *> procData;
+        try {
+            ckpt . in    = static_cast<const unsigned char *>(mapped);
+            ckpt . inEnd = ckpt . in + length;
+            if(string(ckpt . in, ckpt . in + magicLength) != checkpointMagic) {
+                throw CExc("Checkpoint::restore()",
+                           fileName + " n'est pas un checkpoint");
+            }
+            ckpt . in += magicLength;
+
+            // tous les nombres d'elements sont bornes par la taille du
+            // fichier (au moins un octet chacun), sauf les cases memoire
+            const unsigned long maxCount (length);
+            procData . assign(ckpt . getCount(maxCount), 0);
+            vector<ProcInfo::ProcExit> procExit (
+                ckpt . getCount(procData . size()));
+            for(unsigned int k = 0; k < procExit . size(); ++k) {
+                procExit[k] . generation = ckpt . getVarint();
+                procExit[k] . exitCode   = ckpt . getVarint();
+            }
+            const unsigned long reapedCount (ckpt . getVarint());
+            vector<int> freePids (ckpt . getCount(procData . size()));
+            for(unsigned int k = 0; k < freePids . size(); ++k) {
+                freePids[k] = ckpt . getPid(procData . size());
+            }
+            vector<int> zombiePids (ckpt . getCount(procData . size()));
+            for(unsigned int k = 0; k < zombiePids . size(); ++k) {
+                zombiePids[k] = ckpt . getPid(procData . size());
+            }
+            const int outstandingProcCount (ckpt . getInt());
+            const int mutex                (ckpt . getInt());
+            const int mutexOwner           (ckpt . getInt());
+            if(mutexOwner >= static_cast<int>(procData . size())) {
+                throw CExc("Checkpoint::restore()",
+                           fileName + " : detenteur du mutex invalide");
+            }
+            const int sharedMemoryBase     (ckpt . getInt());
+            const int sharedMemoryLimit    (ckpt . getInt());
+            vector<int> sharedMemory;
+            ckpt . getCells(&sharedMemory);
+
+            for(unsigned int kProc = 0; kProc < procData . size(); ++kProc) {
+                if(!ckpt . getVarint()) continue; // pid libre
+                const string progName (ckpt . getString());
+                if(!models . count(progName)) {
+                    throw CExc("Checkpoint::restore()", fileName + " : "
+                               + progName + " n'est pas charge");
+                }
+                const ProcInfo::ProcData & model (*models[progName]);
+                ProcInfo::ProcData * pData (new ProcInfo::ProcData(model));
+                procData[kProc] = pData;
+                pData -> procStatus = ckpt . getVarint() ?
+                    ProcInfo::STAT_TERMINATED : ProcInfo::STAT_WAITING;
+                pData -> procMutexStatus =
+                    static_cast<ProcInfo::ProcStatus>(ckpt . getVarint());
+                pData -> nextLineNumber = ckpt . getInt();
+                pData -> qReapable      = ckpt . getVarint();
+                pData -> exitCode       =
+                    static_cast<ProcInfo::ProcExitCode>(ckpt . getVarint());
+                Sigemptyset(&pData -> sigMask);
+                for(unsigned long nbSig (ckpt . getVarint()); nbSig; --nbSig) {
+                    const unsigned long sig (ckpt . getVarint());
+                    if(sig < 1 || sig >= static_cast<unsigned long>(CstSigMax)) {
+                        throw CExc("Checkpoint::restore()",
+                                   fileName + " : signal invalide");
+                    }
+                    Sigaddset(&pData -> sigMask, sig);
+                }
+                ckpt . checkCount(pData -> symbolTable . size(), "symboles");
+                for(unsigned int k = 0; k < pData -> symbolTable . size(); ++k) {
+                    pData -> symbolTable[k] . value = ckpt . getInt();
+                }
+                pData -> heapMemoryLimit = ckpt . getInt();
+                ckpt . getCells(&pData -> heapMemory);
+                ckpt . checkCount(ProcInfo::countInstructions(pData -> proGram),
+                                  "instructions");
+                ckpt . getTree(pData -> proGram);
+                ckpt . checkCount(ProcInfo::countInstructions(pData -> hanDler),
+                                  "instructions de traitant");
+                ckpt . getTree(pData -> hanDler);
+            }
+
+            for(unsigned int k = 0; k < zombiePids . size(); ++k) {
+                if(!procData[zombiePids[k]]) {
+                    throw CExc("Checkpoint::restore()",
+                               fileName + " : fils a liberer inexistant");
+                }
+            }
+
+            Scheduler & sched (*pInfo -> scheduler);
+            vector<deque<int> > queues (ckpt . getCount(maxCount));
+            if(queues . empty()) {
+                throw CExc("Checkpoint::restore()",
+                           fileName + " : nombre de CPUs invalide");
+            }
+            vector<Scheduler::CpuStat> cpuStat (queues . size());
+            for(unsigned int kCpu = 0; kCpu < queues . size(); ++kCpu) {
+                for(unsigned long nb (ckpt . getVarint()); nb; --nb) {
+                    queues[kCpu] . push_back(ckpt . getPid(procData . size()));
+                    if(!procData[queues[kCpu] . back()]) {
+                        throw CExc("Checkpoint::restore()",
+                                   fileName + " : pid libre en file");
+                    }
+                }
+                cpuStat[kCpu] . busyTicks = ckpt . getVarint();
+                cpuStat[kCpu] . idleTicks = ckpt . getVarint();
+                cpuStat[kCpu] . steals    = ckpt . getVarint();
+            }
+            const unsigned long tickCount (ckpt . getVarint());
+            vector<Scheduler::ProcAffinity> procAffinity (
+                ckpt . getCount(maxCount));
+            for(unsigned int k = 0; k < procAffinity . size(); ++k) {
+                procAffinity[k] . cpu        = ckpt . getInt();
+                procAffinity[k] . migrations = ckpt . getVarint();
+                procAffinity[k] . lastTick   = ckpt . getVarint();
+                if(procAffinity[k] . cpu >= static_cast<int>(queues . size())) {
+                    procAffinity[k] . cpu = -1;
+                }
+            }
+            const unsigned long stepsSinceProgress (ckpt . getVarint());
+            const int           mutexWaitCount     (ckpt . getInt());
+            if(ckpt . in != ckpt . inEnd) {
+                throw CExc("Checkpoint::restore()",
+                           fileName + " : donnees en trop a la fin");
+            }
+
+            // tout est relu : on remplace, sans le debugger (SIGQUIT)
+            // au milieu, comme dans ProcInfo::reapZombies()
+            sigset_t sigQuit, oldMask;
+            Sigemptyset(&sigQuit);
+            Sigaddset  (&sigQuit, SIGQUIT);
+            Sigprocmask(SIG_BLOCK, &sigQuit, &oldMask);
+            for(unsigned int kProc = 0; kProc < pInfo -> procData . size();
+                ++kProc) {
+                delete pInfo -> procData[kProc];
+            }
+            pInfo -> procData . swap(procData);
+            procData . clear(); // plus a nous : rien a liberer ci-dessous
+            pInfo -> procExit             . swap(procExit);
+            pInfo -> reapedCount          = reapedCount;
+            pInfo -> freePids             . swap(freePids);
+            pInfo -> zombiePids           . swap(zombiePids);
+            pInfo -> outstandingProcCount = outstandingProcCount;
+            pInfo -> mutex                = mutex;
+            pInfo -> mutexOwner           = mutexOwner;
+            pInfo -> sharedMemoryBase     = sharedMemoryBase;
+            pInfo -> sharedMemoryLimit    = sharedMemoryLimit;
+            pInfo -> sharedMemory         . swap(sharedMemory);
+            // seuls les watchpoints sur la memoire partagee survivent
+            pInfo -> watchCount           = pInfo -> sharedWatch . cells . size();
+            pInfo -> watchHit . procPid   = ProcInfo::invalidProcPid;
+            sched . waitQueue             . swap(queues);
+            // un READ en attente a ete sauve en file : il recommencera
+            pInfo -> ioWaitPids           . clear();
+            pInfo -> device               . cancelAll(tickCount);
+            sched . cpuStat               . swap(cpuStat);
+            sched . procAffinity          . swap(procAffinity);
+            sched . tickCount             = tickCount;
+            sched . stepsSinceProgress    = stepsSinceProgress;
+            sched . mutexWaitCount        = mutexWaitCount;
+            Sigprocmask(SIG_SETMASK, &oldMask, 0);
+        }
+        catch (...) {
+            for(unsigned int kProc = 0; kProc < procData . size(); ++kProc) {
+                delete procData[kProc];
+            }
+            Munmap(mapped, length);
+            throw;
+        }
+        Munmap(mapped, length);
+    } // restore()
+
+} // namespace ProcDebug
@@ -0,0 +1,368 @@
+/**
+ *
+ * @File : DbgServer.cxx
+ *
+ * @Synopsis : le debugger sur une socket Unix (voir DbgServer.h)
+ *
+ **/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <pthread.h>
+
+#include "DbgServer.h"
+#include "CheckPthread.h"
+#include "nsSysteme.h"
+
+using namespace std;
+using namespace nsSysteme;
+
+namespace ProcDebug {
+
+    namespace {
+        // une ligne plus longue n'est pas une commande : on ferme
+        const string::size_type MAX_LINE = 4096;
+        // a la fin, le temps laisse aux clients pour lire leurs reponses
+        const int STOP_WAIT_MS = 100;
+        const int STOP_WAITS   = 10;
+
+        void setNonBlock(const int fd) {
+            const int flags (::fcntl(fd, F_GETFL));
+            if(flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+                throw CExc("setNonBlock()", fd);
+            }
+        }
+
+        void fillAddress(const string &path, sockaddr_un *pAddr) {
+            if(path . empty() || path . size() >= sizeof(pAddr -> sun_path)) {
+                throw CExc("DbgServer", "Chemin de socket invalide " + path
+                                        + "\n");
+            }
+            memset(pAddr, 0, sizeof(*pAddr));
+            pAddr -> sun_family = AF_UNIX;
+            memcpy(pAddr -> sun_path, path . c_str(), path . size());
+        }
+    }
+
+    DbgServer::DbgServer(const string &p) : path (p), listenFd (-1),
+                                            nextClient (0), qStop (false) {
+        sockaddr_un addr;
+        fillAddress(path, &addr);
+        // la socket d'une simulation precedente, mais rien d'autre
+        struct stat oldStat;
+        if(::lstat(path . c_str(), &oldStat) == 0 &&
+           S_ISSOCK(oldStat . st_mode)) {
+            Unlink(path . c_str());
+        }
+        if((listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+            throw CExc("DbgServer::DbgServer()", "socket()\n");
+        }
+        if(::bind(listenFd, reinterpret_cast<sockaddr *>(&addr),
+                  sizeof(addr)) < 0 || ::listen(listenFd, 8) < 0) {
+            const CExc exc ("DbgServer::DbgServer()", path + "\n");
+            ::close(listenFd);
+            throw exc;
+        }
+        setNonBlock(listenFd);
+        if(::pipe(wakeFd) < 0) {
+            throw CExc("DbgServer::DbgServer()", "pipe()\n");
+        }
+        setNonBlock(wakeFd[0]);
+        setNonBlock(wakeFd[1]);
+        checkPthread(pthread_mutex_init(&lock, 0),     "pthread_mutex_init()");
+        checkPthread(pthread_cond_init (&cmdReady, 0), "pthread_cond_init()");
+        checkPthread(pthread_create(&thread, 0, serverMain, this),
+                     "pthread_create()");
+    }
+
+    DbgServer::~DbgServer() {
+        pthread_mutex_lock(&lock);
+        qStop = true;
+        pthread_mutex_unlock(&lock);
+        wake();
+        pthread_join(thread, 0);
+        ::close(listenFd);
+        ::close(wakeFd[0]);
+        ::close(wakeFd[1]);
+        ::unlink(path . c_str());
+        pthread_cond_destroy(&cmdReady);
+        pthread_mutex_destroy(&lock);
+    }
+
+    void DbgServer::wake() {
+        const char c ('w');
+        // plein : poll() sera reveille de toute facon
+        if(::write(wakeFd[1], &c, 1) < 0) return;
+    }
+
+    bool DbgServer::takeCommand(string *pLine, int *pClient,
+                                const bool qWait) {
+        pthread_mutex_lock(&lock);
+        while(qWait && commands . empty()) {
+            pthread_cond_wait(&cmdReady, &lock);
+        }
+        const bool qGot (!commands . empty());
+        if(qGot) {
+            *pClient = commands . front() . first;
+            pLine -> swap(commands . front() . second);
+            commands . pop_front();
+        }
+        pthread_mutex_unlock(&lock);
+        return qGot;
+    }
+
+    void DbgServer::reply(const int client, const string &text) {
+        pthread_mutex_lock(&lock);
+        const map<int, Client>::iterator i (clients . find(client));
+        if(i != clients . end()) { // parti entre-temps
+            i -> second . out += text;
+            i -> second . out += "@done\n";
+            --i -> second . nbPending;
+        }
+        pthread_mutex_unlock(&lock);
+        wake();
+    }
+
+    void DbgServer::broadcast(const string &text) {
+        if(text . empty()) return;
+        pthread_mutex_lock(&lock);
+        for(map<int, Client>::iterator i (clients . begin());
+            i != clients . end(); ++i) {
+            i -> second . out += text;
+        }
+        pthread_mutex_unlock(&lock);
+        wake();
+    }
+
+    void * DbgServer::serverMain(void *arg) {
+        // les signaux sont pour le thread principal
+        sigset_t allSig;
+        sigfillset(&allSig);
+        pthread_sigmask(SIG_BLOCK, &allSig, 0);
+        static_cast<DbgServer *>(arg) -> serverLoop();
+        return 0;
+    }
+
+    // seul ce thread ouvre, ferme et lit les sockets ; clients est sous
+    // lock parce que reply() et broadcast() remplissent les out
+
+    void DbgServer::serverLoop() {
+        vector<pollfd> pfds;
+        vector<int>    ids;
+        for(int nbStopWaits (0); ; ) {
+            pfds . clear();
+            ids  . clear();
+            pollfd pfd;
+            pfd . revents = 0;
+            pfd . fd      = wakeFd[0];
+            pfd . events  = POLLIN;
+            pfds . push_back(pfd);
+            pthread_mutex_lock(&lock);
+            const bool qStopping (qStop);
+            bool qPending (false);
+            if(!qStopping) {
+                pfd . fd = listenFd;
+                pfds . push_back(pfd);
+            }
+            for(map<int, Client>::iterator i (clients . begin());
+                i != clients . end(); ++i) {
+                pfd . fd     = i -> second . fd;
+                pfd . events = (i -> second . qEof ? 0 : POLLIN) |
+                               (i -> second . out . empty() ? 0 : POLLOUT);
+                qPending |= !i -> second . out . empty();
+                // parti, en attente de ses reponses : POLLHUP sans fin
+                if(!pfd . events) continue;
+                pfds . push_back(pfd);
+                ids  . push_back(i -> first);
+            }
+            pthread_mutex_unlock(&lock);
+            if(qStopping && (!qPending || nbStopWaits++ == STOP_WAITS)) break;
+
+            if(::poll(&pfds[0], pfds . size(),
+                      qStopping ? STOP_WAIT_MS : -1) <= 0) {
+                continue; // EINTR, ou l'attente de la fin
+            }
+            if(pfds[0] . revents) {
+                char drain[64];
+                while(::read(wakeFd[0], drain, sizeof(drain)) > 0) {}
+            }
+            const unsigned int first (qStopping ? 1 : 2);
+            if(!qStopping && (pfds[1] . revents & POLLIN)) {
+                const int fd (::accept(listenFd, 0, 0));
+                if(fd >= 0) {
+                    try {
+                        setNonBlock(fd);
+                        Client client;
+                        client . fd        = fd;
+                        client . qEof      = false;
+                        client . nbPending = 0;
+                        pthread_mutex_lock(&lock);
+                        clients[nextClient++] = client;
+                        pthread_mutex_unlock(&lock);
+                    }
+                    catch (const CExc & Exc) {
+                        ::close(fd);
+                    }
+                }
+            }
+            for(unsigned int k (first); k < pfds . size(); ++k) {
+                if(pfds[k] . revents & POLLOUT) {
+                    writeClient(ids[k - first]);
+                }
+                if(pfds[k] . revents & (POLLIN | POLLHUP | POLLERR)) {
+                    readClient(ids[k - first]);
+                }
+            }
+        }
+        pthread_mutex_lock(&lock);
+        for(map<int, Client>::iterator i (clients . begin());
+            i != clients . end(); ++i) {
+            ::close(i -> second . fd);
+        }
+        clients . clear();
+        pthread_mutex_unlock(&lock);
+    }
+
+    // ses lignes completes deviennent des commandes ; a la fin de sa
+    // connexion, il s'en va (les commandes deja prises restent)
+
+    void DbgServer::readClient(const int id) {
+        pthread_mutex_lock(&lock);
+        const map<int, Client>::iterator i (clients . find(id));
+        if(i == clients . end()) { // ferme par writeClient()
+            pthread_mutex_unlock(&lock);
+            return;
+        }
+        Client & client (i -> second);
+        char buf[4096];
+        const ssize_t got (client . qEof ? 0 : ::read(client . fd, buf,
+                                                       sizeof(buf)));
+        if(got < 0 && (errno == EAGAIN || errno == EINTR)) {
+            pthread_mutex_unlock(&lock);
+            return;
+        }
+        if(got < 0) {
+            ::close(client . fd);
+            clients . erase(i);
+            pthread_mutex_unlock(&lock);
+            return;
+        }
+        if(got == 0) { // il a fini d'ecrire, pas forcement de lire
+            client . qEof = true;
+            closeIfDone(i);
+            pthread_mutex_unlock(&lock);
+            return;
+        }
+        // la borne porte sur la ligne en cours, pas sur ce qu'a rendu
+        // read() : des commandes courtes a la suite passent toujours
+        for(const char *p (buf), *end (buf + got); p < end; ) {
+            const char *nl (static_cast<const char *>(
+                                memchr(p, '\n', end - p)));
+            client . in . append(p, nl ? nl : end);
+            if(client . in . size() > MAX_LINE) {
+                ::close(client . fd);
+                clients . erase(i);
+                pthread_mutex_unlock(&lock);
+                return;
+            }
+            if(!nl) break;
+            if(client . in . size() && client . in[client . in . size() - 1]
+                                       == '\r') {
+                client . in . resize(client . in . size() - 1);
+            }
+            commands . push_back(make_pair(id, string()));
+            commands . back() . second . swap(client . in);
+            ++client . nbPending;
+            pthread_cond_signal(&cmdReady);
+            p = nl + 1;
+        }
+        pthread_mutex_unlock(&lock);
+    }
+
+    void DbgServer::writeClient(const int id) {
+        pthread_mutex_lock(&lock);
+        const map<int, Client>::iterator i (clients . find(id));
+        if(i != clients . end() && i -> second . out . size()) {
+            const ssize_t done (::send(i -> second . fd,
+                                       i -> second . out . data(),
+                                       i -> second . out . size(),
+                                       MSG_NOSIGNAL));
+            if(done >= 0) {
+                i -> second . out . erase(0, done);
+                closeIfDone(i);
+            }
+            else if(errno != EAGAIN && errno != EINTR) {
+                ::close(i -> second . fd); // parti
+                clients . erase(i);
+            }
+        }
+        pthread_mutex_unlock(&lock);
+    }
+
+    bool DbgServer::closeIfDone(map<int, Client>::iterator i) {
+        if(!i -> second . qEof || i -> second . nbPending ||
+           i -> second . out . size()) {
+            return false;
+        }
+        ::close(i -> second . fd);
+        clients . erase(i);
+        return true;
+    }
+
+    int DbgServer::attach(const string &path) {
+        sockaddr_un addr;
+        fillAddress(path, &addr);
+        const int fd (::socket(AF_UNIX, SOCK_STREAM, 0));
+        if(fd < 0) {
+            throw CExc("DbgServer::attach()", "socket()\n");
+        }
+        if(::connect(fd, reinterpret_cast<sockaddr *>(&addr),
+                     sizeof(addr)) < 0) {
+            throw CExc("DbgServer::attach()", path + "\n");
+        }
+        Signal(SIGPIPE, SIG_IGN); // le serveur parti : on le verra au read
+        pollfd pfds[2];
+        pfds[0] . fd     = 0;
+        pfds[0] . events = POLLIN;
+        pfds[1] . fd     = fd;
+        pfds[1] . events = POLLIN;
+        for(char buf[4096]; ; ) {
+            if(::poll(pfds, 2, -1) < 0) {
+                if(errno == EINTR) continue;
+                throw CExc("DbgServer::attach()", "poll()\n");
+            }
+            if(pfds[1] . revents) {
+                const size_t got (Read(fd, buf, sizeof(buf)));
+                if(!got) break; // la simulation est finie
+                for(size_t done (0); done < got; ) {
+                    done += Write(1, buf + done, got - done);
+                }
+            }
+            if(pfds[0] . revents) {
+                const size_t got (Read(0, buf, sizeof(buf)));
+                if(!got) { // plus de commandes : on lit encore les reponses
+                    ::shutdown(fd, SHUT_WR);
+                    pfds[0] . fd = -1;
+                    continue;
+                }
+                for(size_t done (0); done < got; ) {
+                    done += Write(fd, buf + done, got - done);
+                }
+            }
+        }
+        Close(fd);
+        return 0;
+    }
+
+} // namespace ProcDebug
@@ -0,0 +1,81 @@
+/**
+ *
+ * @File : DbgThread.cxx
+ *
+ * @Synopsis : debugger non-stop (voir DbgThread.h)
+ *
+ **/
+
+#include <iostream>
+#include <string>
+#include <deque>
+#include <signal.h>
+#include <pthread.h>
+
+#include "DbgThread.h"
+#include "CheckPthread.h"
+#include "nsSysteme.h"
+
+using namespace std;
+using namespace nsSysteme;
+
+namespace ProcDebug {
+
+    DbgThread::DbgThread(istream &input) : in (input), qEof (false) {
+        checkPthread(pthread_mutex_init(&lock, 0),     "pthread_mutex_init()");
+        checkPthread(pthread_cond_init (&cmdReady, 0), "pthread_cond_init()");
+        checkPthread(pthread_create(&thread, 0, readerMain, this),
+                     "pthread_create()");
+        pthread_detach(thread);
+    }
+
+    // le thread lecteur peut encore etre dans getline() : on ne detruit
+    // pas ce qu'il utilise, le processus se termine de toute facon
+
+    DbgThread::~DbgThread() {}
+
+    void * DbgThread::readerMain(void *arg) {
+        // SIGQUIT et les signaux du SIGNAL du minilangage sont pour le
+        // thread principal
+        sigset_t allSig;
+        sigfillset(&allSig);
+        pthread_sigmask(SIG_BLOCK, &allSig, 0);
+        static_cast<DbgThread *>(arg) -> readerLoop();
+        return 0;
+    }
+
+    void DbgThread::readerLoop() {
+        for(string line; getline(in, line); ) {
+            pthread_mutex_lock(&lock);
+            commands . push_back(line);
+            pthread_cond_signal(&cmdReady);
+            pthread_mutex_unlock(&lock);
+        }
+        pthread_mutex_lock(&lock);
+        qEof = true;
+        pthread_cond_signal(&cmdReady);
+        pthread_mutex_unlock(&lock);
+    }
+
+    bool DbgThread::takeCommand(string *pLine, const bool qWait) {
+        pthread_mutex_lock(&lock);
+        while(qWait && commands . empty() && !qEof) {
+            pthread_cond_wait(&cmdReady, &lock);
+        }
+        const bool qGot (!commands . empty());
+        if(qGot) {
+            pLine -> swap(commands . front());
+            commands . pop_front();
+        }
+        pthread_mutex_unlock(&lock);
+        return qGot;
+    }
+
+    bool DbgThread::qAtEnd() {
+        pthread_mutex_lock(&lock);
+        const bool qEnd (qEof && commands . empty());
+        pthread_mutex_unlock(&lock);
+        return qEnd;
+    }
+
+} // namespace ProcDebug
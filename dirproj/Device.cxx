@@ -0,0 +1,80 @@
+/**
+ *
+ * @File : Device.cxx
+ *
+ * @Synopsis : peripherique bloc simule (voir Device.h)
+ *
+ **/
+
+#include <iostream>
+#include <vector>
+#include <deque>
+
+#include "Device.h"
+
+using namespace std;
+
+namespace ProcDebug {
+
+    const unsigned int Device::DEFAULT_LATENCY;
+    const unsigned int Device::DEFAULT_BANDWIDTH;
+    const unsigned int Device::DEFAULT_BLOCK_WORDS;
+    const unsigned int Device::DEFAULT_BLOCKS;
+
+    Device::Device() : freeTick (0), nbReads (0), nbWrites (0),
+                       busyTicks (0), totalTicks (0) {
+        configure(DEFAULT_LATENCY, DEFAULT_BANDWIDTH, DEFAULT_BLOCK_WORDS,
+                  DEFAULT_BLOCKS);
+    }
+
+    void Device::configure(const unsigned int lat, const unsigned int bw,
+                           const unsigned int words,
+                           const unsigned int nbBlocks) {
+        latency   = lat;
+        bandwidth = bw;
+        nbWords   = words;
+        blocks . assign(nbBlocks, vector<int>(nbWords, 0));
+    }
+
+    void Device::submit(const int procPid, const bool qWrite,
+                        const unsigned long now) {
+        const unsigned long service (latency +
+                                     (nbWords + bandwidth - 1) / bandwidth);
+        Request request;
+        request . procPid    = procPid;
+        request . submitTick = now;
+        request . doneTick   = (freeTick > now ? freeTick : now) + service;
+        freeTick = request . doneTick;
+        pending . push_back(request);
+        busyTicks  += service;
+        totalTicks += request . doneTick - now;
+        ++(qWrite ? nbWrites : nbReads);
+    }
+
+    bool Device::takeDone(const unsigned long now, int *pProcPid) {
+        if(pending . empty() || pending . front() . doneTick > now) {
+            return false;
+        }
+        *pProcPid = pending . front() . procPid;
+        pending . pop_front();
+        return true;
+    }
+
+    // debit en entiers par tick, occupation du disque, et temps moyen
+    // d'une requete (attente derriere les autres comprise)
+
+    void Device::dumpStat(ostream *s, const unsigned long ticks) const {
+        const unsigned long nbRequests (nbReads + nbWrites);
+        if(!nbRequests) return;
+        (*s) << "Device: " << nbReads << " read(s), " << nbWrites
+             << " write(s) of " << nbWords << " words, latency " << latency
+             << " bandwidth " << bandwidth << "\n"
+             << "  busy " << busyTicks << " ticks utilization "
+             << (ticks ? 100 * busyTicks / ticks : 0) << "% throughput "
+             << (ticks ? static_cast<double>(nbRequests * nbWords) / ticks
+                       : 0.0)
+             << " words/tick mean request time "
+             << static_cast<double>(totalTicks) / nbRequests << " ticks\n";
+    }
+
+} // namespace ProcDebug
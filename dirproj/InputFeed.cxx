@@ -0,0 +1,198 @@
+/**
+ *
+ * @File : InputFeed.cxx
+ *
+ * @Synopsis : sources d'entree des READ (voir InputFeed.h)
+ *
+ **/
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <limits.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "InputFeed.h"
+#include "nsSysteme.h"
+
+using namespace std;
+using namespace nsSysteme;
+
+namespace ProcDebug {
+
+    namespace {
+        // un entier, jusqu'a end ou au ':' qui suit ; 0 si ce n'en est pas
+        const char * parseInt(const char *str, int *pValue) {
+            char * end;
+            errno = 0;
+            const long v (strtol(str, &end, 10));
+            if(end == str || errno || v < INT_MIN || v > INT_MAX) return 0;
+            *pValue = static_cast<int>(v);
+            return end;
+        }
+    }
+
+    InputFeed::InputFeed(const string &src, const unsigned int defaultSeed) :
+        kind (FEED_FILE), source (src), pos (0), qWarned (false),
+        constValue (0), range (0), state (defaultSeed) {
+        const char * p (0);
+        if(source . compare(0, 5, "file:") == 0 && source . size() > 5) {
+            readFile(source . substr(5));
+            return;
+        }
+        if(source . compare(0, 6, "const:") == 0) {
+            kind = FEED_CONST;
+            p = parseInt(source . c_str() + 6, &constValue);
+            if(p && !*p) return;
+        }
+        else if(source . compare(0, 7, "random:") == 0) {
+            kind = FEED_RANDOM;
+            int maxValue;
+            if((p = parseInt(source . c_str() + 7, &constValue)) &&
+               *p == ':' && (p = parseInt(p + 1, &maxValue)) &&
+               constValue <= maxValue) {
+                range = static_cast<unsigned int>(maxValue) -
+                        static_cast<unsigned int>(constValue) + 1;
+                if(*p == ':') { // la graine
+                    char * end;
+                    state = strtoul(p + 1, &end, 10);
+                    p = end == p + 1 ? 0 : end;
+                }
+                // xorshift ne sort jamais de 0
+                if(!state) state = 1;
+                if(p && !*p) return;
+            }
+        }
+        throw CExc("InputFeed::InputFeed()",
+                   "Source d'entree invalide " + source + "\n");
+    }
+
+    // tout le fichier d'un coup, puis les entiers separes par des blancs
+
+    void InputFeed::readFile(const string &fileName) {
+        struct stat fileStat;
+        Stat(fileName . c_str(), &fileStat);
+        string content (fileStat . st_size, '\0');
+        const int fd (Open(fileName . c_str(), O_RDONLY));
+        size_t done (0);
+        while(done < content . size()) {
+            const size_t got (Read(fd, &content[done],
+                                   content . size() - done));
+            if(got == 0) break; // tronque entre-temps
+            done += got;
+        }
+        Close(fd);
+        content . resize(done);
+
+        unsigned int line (1);
+        for(const char * p (content . c_str()); ; ) {
+            while(*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+                if(*p++ == '\n') ++line;
+            }
+            if(!*p) break;
+            int value;
+            const char * end (parseInt(p, &value));
+            if(!end || (*end && *end != ' ' && *end != '\t' &&
+                        *end != '\r' && *end != '\n')) {
+                ostringstream msg;
+                msg << fileName << ":" << line << " : entier attendu\n";
+                throw CExc("InputFeed::readFile()", msg . str());
+            }
+            values . push_back(value);
+            p = end;
+        }
+    }
+
+    int InputFeed::nextRandom() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return static_cast<int>(static_cast<unsigned int>(constValue) +
+                                (range ? state % range : state));
+    }
+
+    bool InputFeed::qAtEnd() {
+        if(!qWarned) {
+            cerr << "INPUT end of " << source
+                 << ", reading stdin from now on\n";
+            qWarned = true;
+        }
+        return false;
+    }
+
+    void StdinLines::poll(const int timeoutMs) {
+        if(qEof) return;
+        struct pollfd pfd;
+        pfd . fd     = fd;
+        pfd . events = POLLIN;
+        // interrompu (SIGQUIT...) : on reviendra au tick suivant
+        if(::poll(&pfd, 1, timeoutMs) <= 0) return;
+        char buf[4096];
+        const ssize_t got (::read(fd, buf, sizeof(buf)));
+        if(got < 0) return; // EINTR, EAGAIN : idem
+        if(got == 0) {
+            qEof = true;
+            if(partial . size()) {
+                lines . push_back(partial);
+                partial . clear();
+            }
+            return;
+        }
+        for(const char *p (buf), *end (buf + got); p < end; ) {
+            const char *nl (static_cast<const char *>(
+                                memchr(p, '\n', end - p)));
+            if(!nl) {
+                partial . append(p, end);
+                break;
+            }
+            partial . append(p, nl);
+            lines . push_back(string());
+            lines . back() . swap(partial);
+            p = nl + 1;
+        }
+    }
+
+    bool StdinLines::takeLine(string *pLine) {
+        if(lines . empty()) return false;
+        pLine -> swap(lines . front());
+        lines . pop_front();
+        return true;
+    }
+
+    bool StdinLines::getLine(string *pLine) {
+        while(lines . empty() && !qEof) poll(-1);
+        return takeLine(pLine);
+    }
+
+    InputFeeds::~InputFeeds() {
+        delete shared;
+        for(map<string, InputFeed *>::iterator i (byProg . begin());
+            i != byProg . end(); ++i) {
+            delete i -> second;
+        }
+    }
+
+    // deux instances du meme fichier n'ont qu'une source, a elles deux
+
+    void InputFeeds::add(const string &progName, InputFeed *feed) {
+        InputFeed * & slot (progName . empty() ? shared : byProg[progName]);
+        if(slot) {
+            delete feed;
+            throw CExc("InputFeeds::add()", "Deux sources d'entree pour "
+                       + (progName . empty() ? string("tous") : progName)
+                       + "\n");
+        }
+        slot = feed;
+    }
+
+} // namespace ProcDebug
@@ -0,0 +1,138 @@
+/**
+ *
+ * @File : Journal.cxx
+ *
+ * @Synopsis : enregistrement et rejeu (voir Journal.h)
+ *
+ **/
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include "Journal.h"
+#include "nsSysteme.h"
+
+using namespace std;
+using namespace nsSysteme;
+
+namespace ProcDebug {
+
+    namespace {
+        const char         journalMagic[] = "PDJ1";
+        const unsigned int headerLength   = 8; // magic + graine
+    }
+
+    const unsigned char Journal::READ_TAG;
+    const unsigned char Journal::INPUT_END_TAG;
+    const unsigned int  Journal::BUF_SIZE;
+
+    Journal::Journal(const string &fName, const JournalMode m,
+                     const unsigned int s) :
+        mode (m), fileName (fName), seed (s), fd (-1),
+        bufLength (0), readPos (headerLength) {
+        if(mode == JOURNAL_RECORD) {
+            fd = Open(fileName . c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            for(unsigned int k = 0; k < 4; ++k) putByte(journalMagic[k]);
+            for(unsigned int k = 0; k < 4; ++k) putByte((seed >> 8*k) & 0xFF);
+            return;
+        }
+        // en rejeu, le fichier entier en memoire : il est compact
+        struct stat fileStat;
+        Stat(fileName . c_str(), &fileStat);
+        content . resize(fileStat . st_size);
+        fd = Open(fileName . c_str(), O_RDONLY);
+        for(size_t done = 0; done < content . size(); ) {
+            const size_t got (Read(fd, &content[done],
+                                   content . size() - done));
+            if(got == 0) {
+                content . resize(done); // tronque entre-temps
+                break;
+            }
+            done += got;
+        }
+        Close(fd);
+        fd = -1;
+        if(content . size() < headerLength ||
+           string(content . begin(), content . begin() + 4) != journalMagic) {
+            throw CExc("Journal::Journal()",
+                       fileName + " n'est pas un journal");
+        }
+        seed = 0;
+        for(unsigned int k = 0; k < 4; ++k) seed |= content[4 + k] << 8*k;
+    } // Journal()
+
+    Journal::~Journal() {
+        if(fd < 0) return;
+        try {
+            flush();
+            Close(fd);
+        }
+        catch (const CExc & Exc) {
+            cerr << Exc << endl;
+        }
+    }
+
+    void Journal::flush() {
+        for(unsigned int done = 0; done < bufLength; ) {
+            done += Write(fd, buf + done, bufLength - done);
+        }
+        bufLength = 0;
+    }
+
+    // a la fin du journal, on repasse en direct, en le disant une fois
+
+    bool Journal::qAtEnd() {
+        if(readPos < content . size()) return false;
+        if(mode == JOURNAL_REPLAY) {
+            cerr << "REPLAY end of journal " << fileName
+                 << ", running live from now on\n";
+            mode = JOURNAL_OFF;
+            content . clear();
+        }
+        return true;
+    }
+
+    unsigned int Journal::getVarint() {
+        unsigned int v (0);
+        for(unsigned int shift = 0; readPos < content . size(); shift += 7) {
+            const unsigned char c (content[readPos++]);
+            v |= (c & 0x7F) << shift;
+            if(!(c & 0x80)) return v;
+        }
+        throw CExc("Journal::getVarint()", fileName + " tronque");
+    }
+
+    bool Journal::replayElection(int *pProcPid) {
+        if(qAtEnd()) return false;
+        if(content[readPos] == READ_TAG ||
+           content[readPos] == INPUT_END_TAG) {
+            throw CExc("Journal::replayElection()",
+                       "le rejeu a diverge : READ attendu dans " + fileName);
+        }
+        *pProcPid = static_cast<int>(getVarint() >> 1) - 1;
+        return true;
+    }
+
+    bool Journal::replayRead(int *pValue, bool *pqInputEnd) {
+        if(qAtEnd()) return false;
+        *pqInputEnd = content[readPos] == INPUT_END_TAG;
+        if(*pqInputEnd) {
+            ++readPos;
+            return true;
+        }
+        if(content[readPos] != READ_TAG) {
+            throw CExc("Journal::replayRead()",
+                       "le rejeu a diverge : election attendue dans "
+                       + fileName);
+        }
+        ++readPos;
+        const unsigned int v (getVarint());
+        *pValue = static_cast<int>(v >> 1) ^ -static_cast<int>(v & 1);
+        return true;
+    }
+
+} // namespace ProcDebug
@@ -10,13 +10,15 @@
 
 #include <iostream>
 #include <sstream>
-#include <fstream>
+#include <iomanip>
 #include <string>
 #include <vector>
 #include <cctype>
 #include <algorithm>
 
 #include "MiniDbg.h"
+#include "Checkpoint.h"
+#include "Journal.h"
 #include "nsSysteme.h"
 
 using namespace std;
@@ -26,81 +28,111 @@ using namespace ProcDebug;
 // À afficher si on essaye d'exécuter une commande sur un processus terminé
 #define PROCENDED "Processus déjà terminé\n"
 
+// Une expression (print, display, condition d'un breakpoint) incalculable
+#define EVALFAILED "Division par zéro ou case hors de la mémoire"
+
 // idem que dans ProcDebug.cxx
 #define STATUS procData[m_Proc] -> procStatus
 
 namespace ProcDebug
 {
 
-    MiniDbg::MiniDbg (ProcInfo * procInfo, int Proc) throw()
-    : m_ProcInfo (procInfo), m_Proc (Proc), m_GoOut (false) {}
+    MiniDbg::MiniDbg (ProcInfo * procInfo, int Proc,
+                      istream & In /* = cin */,
+                      bool qMachine /* = false */,
+                      bool qNonStop /* = false */) throw()
+    : m_ProcInfo (procInfo), m_Proc (Proc), m_ListeSuite (-1), m_In (In),
+      m_Msg ((qMachine ? cerr : cout).rdbuf()), m_Sortie (cout.rdbuf()),
+      m_qMachine (qMachine), m_qNonStop (qNonStop),
+      m_Suivi (ProcInfo::invalidProcPid), m_GoOut (false)
+    {
+        // le même ordre entre les deux qu'avec cout et cerr eux-mêmes
+        m_Msg.copyfmt (qMachine ? cerr : cout);
+        m_Sortie.copyfmt (cout);
+    }
+
+    void MiniDbg::Rediriger (streambuf * Tampon) throw ()
+    {
+        m_Msg.rdbuf (Tampon);
+        m_Sortie.rdbuf (Tampon);
+        m_Msg.tie (0);
+        m_Msg.unsetf (ios::unitbuf);
+
+    } // Rediriger()
+
+    // Les commandes et leur traitant ; Prompt() y cherche le premier mot
+    const MiniDbg::Commande MiniDbg::s_Commandes [] =
+    {
+        { "continue",         &MiniDbg::GererContinue        },
+        { "step",             &MiniDbg::GererStep            },
+        { "next",             &MiniDbg::GererNext            },
+        { "finish",           &MiniDbg::GererFinish          },
+        { "until",            &MiniDbg::GererUntil           },
+        { "reverse-step",     &MiniDbg::GererReverseStep     },
+        { "reverse-continue", &MiniDbg::GererReverseContinue },
+        { "print",            &MiniDbg::GererPrint           },
+        { "display",          &MiniDbg::GererDisplay         },
+        { "modify",           &MiniDbg::GererModify          },
+        { "break",            &MiniDbg::GererBreak           },
+        { "watch",            &MiniDbg::GererWatch           },
+        { "trace",            &MiniDbg::GererTrace           },
+        { "tdump",            &MiniDbg::GererTdump           },
+        { "x",                &MiniDbg::GererX               },
+        { "xdiff",            &MiniDbg::GererXdiff           },
+        { "checkpoint",       &MiniDbg::GererCheckpoint      },
+        { "restore",          &MiniDbg::GererRestore         },
+        { "show",             &MiniDbg::GererShow            },
+        { "list",             &MiniDbg::GererList            },
+        { "remove",           &MiniDbg::GererRemove          },
+        { "stop",             &MiniDbg::GererStop            },
+        { "start",            &MiniDbg::GererStart           },
+        { "restart",          &MiniDbg::GererRestart         },
+        { "changeproc",       &MiniDbg::GererChangeProc      },
+        { "interrupt",        &MiniDbg::GererInterrupt       },
+        { "status",           &MiniDbg::GererStatus          },
+        { "end",              &MiniDbg::GererEnd             },
+        { "quit",             &MiniDbg::GererQuit            }
+    };
 
     void MiniDbg::Prompt (void) throw ()
     {
-        for (string Str; ; )
+        m_ProcInfo -> output . flush(); // les PRINT avant nos messages
+        m_GoOut = false; // une nouvelle session, après un end précédent
+        m_ListeSuite = -1; // list repart de la ligne courante
+        m_Msg << "Interruption à la ligne "
+              << m_ProcInfo -> procData[m_Proc] -> nextLineNumber -1
+              << '\n';
+        SignalerWatch(); // si c'est une écriture surveillée qui nous amène
+        if (m_qMachine) Arret ("interrupt");
+        else m_ProcInfo -> markStop(); // Arret() le fait sinon
+
+        for (string Ligne; ; )
         {
-            string Prompt (m_ProcInfo -> procData[m_Proc] -> progName +
-                           ":mDbg> ");
-            cout << Prompt;
+            AfficherPrompt();
 
-            getline (cin, Str); // Comme ça, si on tape entrer sans rien,
-                                // on reviens, contrairement à
-                                // si on avait utilisé cin >> 
+            getline (m_In, Ligne); // Comme ça, si on tape entrer sans rien,
+                                   // on reviens, contrairement à
+                                   // si on avait utilisé cin >> 
 
-            if (Str.empty())
+            if (Ligne.empty())
             {
-                // au cas ou un petit c** ferais ctrl+d
-                if (cin.eof())
+                if (m_In.eof())
                 {
-                    cout << '\n'; // uniquement si eof, car sinon
+                    // fin du script : on laisse finir la simulation
+                    if (m_qMachine)
+                    {
+                        FinDesCommandes();
+                        return;
+                    }
+                    // au cas ou un petit c** ferais ctrl+d
+                    m_Msg << '\n'; // uniquement si eof, car sinon
                                   // on l'a déjà fait avec getline
-                    cin.clear();
+                    m_In.clear();
                 }
                 continue;
             }
 
-            // On met la chaine en minuscule au cas ou...
-            transform(Str.begin(), Str.end(),
-                      Str.begin(), (int (*) (int))tolower);
-                // Le troisième paramètre prend un pointeur de fonction
-                // de type int fct (int i), c'est le cas de tolower
-                // mais apparemment le compilateur ne le vois pas...
-
-            m_Cmd.clear(); // sinon les commandes s'accumulent...
-
-            // Pour que les blancs soient ignorés, met la ligne lue
-            // dans le vecteur en passant par un istringstream
-            // c'est mieu que d'utiliser strtok avec " " comme séparateur
-            // (nb: on recycle Str pour la lecture...)
-
-            for (istringstream istr (Str); ! (istr >> Str).eof(); )
-                m_Cmd.push_back(Str);
-            m_Cmd.push_back(Str); // Lorsqu'on éjecte la dernière string,
-                                  // le flux est eof, et on sort sans
-                                  // l'avoir ajouté :(
-
-            if      (m_Cmd[0] == "continue"  ) GererContinue();
-            else if (m_Cmd[0] == "step"      ) GererStep();
-            else if (m_Cmd[0] == "print"     ) GererPrint();
-            else if (m_Cmd[0] == "display"   ) GererDisplay();
-            else if (m_Cmd[0] == "modify"    ) GererModify();
-            else if (m_Cmd[0] == "break"     ) GererBreak();
-            else if (m_Cmd[0] == "show"      ) GererShow();
-            else if (m_Cmd[0] == "remove"    ) GererRemove();
-            else if (m_Cmd[0] == "stop"      ) GererStop();
-            else if (m_Cmd[0] == "start"     ) GererStart();
-            else if (m_Cmd[0] == "restart"   ) GererRestart();
-            else if (m_Cmd[0] == "changeproc") GererChangeProc();
-            else if (m_Cmd[0] == "status"    ) GererStatus();
-            else if (m_Cmd[0] == "end"       )
-            {
-                if (-1 != GererEnd()) return;
-            }
-            else if (m_Cmd[0] == "quit"      )
-            {
-                if (-1 != GererQuit()) return;
-            }
-            else cout << "Commande inconnue\n";
+            Executer (Ligne);
 
             if (m_GoOut) return;
             // indispensable, car par exemple : on lance le programme,
@@ -115,106 +147,527 @@ namespace ProcDebug
 
     } // Prompt()
 
+    // Plus de commandes (fin du script, ou de l'entrée en non-stop) :
+    // personne pour les arrêts, on enlève aussi les watchpoints et on
+    // laisse finir la simulation
+
+    void MiniDbg::FinDesCommandes (void) throw ()
+    {
+        for (unsigned i(0); i < m_Watch.size(); ++i)
+            m_ProcInfo -> setWatch (m_Watch[i].m_Proc, m_Watch[i].m_Kind,
+                                    m_Watch[i].m_Cell, false);
+        m_Watch.clear();
+        m_Cmd.assign (1, "end");
+        GererEnd();
+
+    } // FinDesCommandes()
+
+    // Une ligne de commande, lue par Prompt() ou, en non-stop, prise
+    // dans la file du thread lecteur par la boucle principale
+
+    void MiniDbg::Executer (const string & Ligne) throw ()
+    {
+        m_ProcInfo -> output . flush();
+        m_Cmd.clear(); // sinon les commandes s'accumulent...
+
+        // Pour que les blancs soient ignorés, met la ligne lue
+        // dans le vecteur en passant par un istringstream
+        // c'est mieu que d'utiliser strtok avec " " comme séparateur
+
+        istringstream istr (Ligne);
+        for (string Mot; istr >> Mot; ) m_Cmd.push_back(Mot);
+        if (m_Cmd.empty() || '#' == m_Cmd[0][0]) return; // commentaire
+        if (m_qMachine) m_Sortie << "@cmd " << Ligne << '\n';
+
+        // On met la commande en minuscule au cas ou... mais pas ses
+        // arguments : les noms de variables distinguent la casse
+        transform(m_Cmd[0].begin(), m_Cmd[0].end(),
+                  m_Cmd[0].begin(), (int (*) (int))tolower);
+            // Le troisième paramètre prend un pointeur de fonction
+            // de type int fct (int i), c'est le cas de tolower
+            // mais apparemment le compilateur ne le vois pas...
+
+        const unsigned NbCommandes (sizeof s_Commandes /
+                                    sizeof s_Commandes[0]);
+        unsigned i (0);
+        while (i < NbCommandes && m_Cmd[0] != s_Commandes[i].m_Nom) ++i;
+        if (i < NbCommandes)
+            (this ->* s_Commandes[i].m_Gerer) ();
+        else
+            Erreur() << "Commande inconnue\n";
+        SignalerEchec();
+
+    } // Executer()
+
+    void MiniDbg::SignalerEchec (void) throw ()
+    {
+        string Texte (m_Erreur.str());
+        if (Texte.empty()) return;
+        m_Erreur.str ("");
+        // sur le socket, m_Msg et m_Sortie vont au même endroit : la
+        // ligne @error suffit
+        if (! m_qMachine || m_Msg.rdbuf() != m_Sortie.rdbuf())
+            m_Msg << Texte;
+        if (! m_qMachine) return;
+        // sur une seule ligne, les blancs (ceux de la mise en page d'une
+        // CExc compris) réduits à un espace
+        m_Sortie << "@error msg=";
+        istringstream Mots (Texte);
+        string Mot;
+        for (bool qPremier (true); Mots >> Mot; qPremier = false)
+            m_Sortie << (qPremier ? "" : " ") << Mot;
+        m_Sortie << '\n';
+
+    } // SignalerEchec()
+
+    void MiniDbg::AfficherPrompt (void) throw ()
+    {
+        m_ProcInfo -> output . flush(); // ce qu'ont affiché les pas faits
+        if (m_qMachine) return;
+        m_Msg << m_ProcInfo -> procData[m_Proc] -> progName << ":mDbg> "
+              << flush;
+
+    } // AfficherPrompt()
+
+    // Non-stop : le processus est arrêté en restant dans sa file
+    // (STAT_TRACEEND, l'ordonnanceur le passe), et les autres tournent ;
+    // on ne change que son état, sans le remettre en file
+
+    void MiniDbg::Tracer (int Pid) throw ()
+    {
+        ProcInfo::ProcStatus & Status (m_ProcInfo -> procData[Pid]
+                                           -> procStatus);
+        if (! m_qNonStop)
+            m_ProcInfo -> updateProcData (Pid, ProcInfo::START_TRACE);
+        else if (Status != ProcInfo::STAT_TERMINATED)
+        {
+            // en attente du disque, il n'était dans aucune file
+            if (Status == ProcInfo::STAT_IOWAIT)
+                m_ProcInfo -> scheduler -> enQueueProc (Pid);
+            Status = ProcInfo::STAT_TRACEEND;
+        }
+
+    } // Tracer()
+
+    void MiniDbg::Detracer (int Pid) throw ()
+    {
+        ProcInfo::ProcStatus & Status (m_ProcInfo -> procData[Pid]
+                                           -> procStatus);
+        if (! m_qNonStop)
+            m_ProcInfo -> updateProcData (Pid, ProcInfo::END_TRACE);
+        else if (Status == ProcInfo::STAT_TRACEEND)
+            Status = ProcInfo::STAT_WAITING;
+
+    } // Detracer()
+
+    void MiniDbg::Arreter (int Pid, const char * Raison) throw ()
+    {
+        m_ProcInfo -> output . flush();
+        m_Proc = Pid;
+        ResoudreDisplay();
+        m_ListeSuite = -1;
+        if (m_Suivi == Pid) m_Suivi = ProcInfo::invalidProcPid;
+        Tracer (Pid);
+        m_Msg << "\nInterruption du processus " << Pid + 1
+              << " à la ligne "
+              << m_ProcInfo -> procData[m_Proc] -> nextLineNumber -1 << '\n';
+        SignalerWatch();
+        Arret (Raison);
+        AfficherPrompt();
+
+    } // Arreter()
+
+    // Non-stop, sur un interblocage : personne ne peut plus avancer,
+    // on les arrête tous, et la boucle principale attend les commandes
+
+    void MiniDbg::ArreterTout (int Pid, const char * Raison) throw ()
+    {
+        for (unsigned i(0); i < m_ProcInfo -> procData.size(); ++i)
+            if (m_ProcInfo -> procData[i] && (int)i != Pid)
+                Tracer (i);
+        Arreter (Pid, Raison);
+
+    } // ArreterTout()
+
+    // Non-stop : après chaque pas du processus relancé par continue
+
+    bool MiniDbg::VerifierBreak (int Pid) throw ()
+    {
+        if (Pid != m_Suivi) return false;
+        const ProcInfo::ProcData * Data (m_ProcInfo -> procData[Pid]);
+        if (Data -> procStatus == ProcInfo::STAT_TERMINATED)
+        {
+            m_Suivi = ProcInfo::invalidProcPid;
+            return false;
+        }
+        const ProgBreaks & Breaks (m_BreakBits[Data -> progName]);
+        const unsigned Ligne (m_ProcInfo -> findCrtInstruction (
+                                  Data -> proGram) -> lineNumber);
+        bool qEchec;
+        if (Ligne >= Breaks.m_Bits.size() || ! Breaks.m_Bits[Ligne] ||
+            ! m_ProcInfo -> evalCond (Pid, Breaks.m_Conds[Ligne], &qEchec))
+            return false;
+        if (qEchec)
+            m_Msg << EVALFAILED " dans la condition du breakpoint ligne "
+                  << Ligne << '\n';
+        Arreter (Pid, qEchec ? "condition-error" : "breakpoint");
+        return true;
+
+    } // VerifierBreak()
+
+    // Un arrêt du processus tracé : en mode machine, une ligne
+    // "@stop reason=<raison> pid=<n> prog=<fichier> line=<n>" ; dans
+    // les deux modes, les variables du display
+
+    void MiniDbg::Arret (const char * Raison) throw ()
+    {
+        m_ProcInfo -> markStop(); // pour xdiff
+        if (m_qMachine)
+        {
+            const ProcInfo::ProcData * Data (m_ProcInfo -> procData[m_Proc]);
+            m_Sortie << "@stop reason=" << Raison << " pid=" << m_Proc + 1
+                 << " prog=" << Data -> progName;
+            if (Data -> procStatus != ProcInfo::STAT_TERMINATED)
+                m_Sortie << " line=" << m_ProcInfo -> findCrtInstruction (
+                                        Data -> proGram) -> lineNumber;
+            m_Sortie << '\n';
+        }
+
+        AfficherDisplay();
+
+    } // Arret()
+
     void MiniDbg::GererContinue () throw ()
     {
         if (1 != m_Cmd.size())
         {
-            cout << "Usage : continue\n";
+            Erreur() << "Usage : continue\n";
             return;
         }
 
         if (m_ProcInfo -> STATUS == ProcInfo::STAT_TERMINATED)
         {
-            cout << PROCENDED;
+            Erreur() << PROCENDED;
             return;
         }
 
-        cout << "Reprise à la ligne "
+        m_Msg << "Reprise à la ligne "
              << m_ProcInfo -> procData[m_Proc] -> nextLineNumber -1
              << '\n';
 
-        // On cherche dans m_Break le prochain point d'interruption
-        // pour ne pas avoir à parcourir tout le vecteur à chaque
-        // fois qu'on avance d'une instruction.
-        // Et puis, on a qu'un seul break par un continue...
+        // Non-stop : c'est l'ordonnanceur qui le fera avancer, parmi les
+        // autres ; la boucle principale teste ses breakpoints
+        if (m_qNonStop)
+        {
+            Detracer (m_Proc);
+            m_Suivi = m_Proc;
+            return;
+        }
 
-        int Breakpoint (0); // initialisé à zero car si on a aucun break,
-                            // on ne s'arretera pas (la ligne 0 n'existe pas)
-        for (vector<int>::iterator i (m_Break.begin());
-             i < m_Break.end(); ++i)
-            if (*i >= m_ProcInfo -> findCrtInstruction(
-                    m_ProcInfo -> procData[m_Proc] -> proGram) -> lineNumber)
-            {
-                Breakpoint = *i;
-                break;
-            }
+        // Les breakpoints du programme tracé : un bit par ligne, testé
+        // à chaque instruction, donc tous sont honorés (boucles comprises)
+        const ProgBreaks & Breaks (
+            m_BreakBits[m_ProcInfo -> procData[m_Proc] -> progName]);
+        const vector<bool> & Bits (Breaks.m_Bits);
 
         // Et on continue uniquement le processs tracé
 
         m_ProcInfo -> avancerDUnPas(m_Proc); // car sinon on reste bloqué
-                                             // à cause du >=
+                                             // sur la ligne courante
         for (; m_ProcInfo -> STATUS != ProcInfo::STAT_TERMINATED; )
         {
             if (m_GoOut) return;
-            if (Breakpoint == m_ProcInfo -> findCrtInstruction(
-                m_ProcInfo -> procData[m_Proc] -> proGram) -> lineNumber)
+            const unsigned Ligne (m_ProcInfo -> findCrtInstruction(
+                m_ProcInfo -> procData[m_Proc] -> proGram) -> lineNumber);
+            bool qEchec;
+            if (Ligne < Bits.size() && Bits[Ligne] &&
+                m_ProcInfo -> evalCond (m_Proc, Breaks.m_Conds[Ligne],
+                                        &qEchec))
             {
-                cout << "\nBreakpoint à la ligne " << Breakpoint << '\n';
+                if (qEchec)
+                    m_Msg << '\n' << EVALFAILED " dans la condition";
+                m_Msg << "\nBreakpoint à la ligne " << Ligne << '\n';
+                Arret (qEchec ? "condition-error" : "breakpoint");
+                return;
+            }
+            if (SignalerWatch())
+            {
+                Arret ("watchpoint");
                 return;
             }
 
             m_ProcInfo -> avancerDUnPas(m_Proc);
         }
+        if (! m_GoOut) Arret ("exited");
 
     } // GererContinue()
 
     void MiniDbg::GererStep () throw ()
     {
-        if (1 != m_Cmd.size())
+        unsigned long NbPas (1);
+        bool          qUsage (2 < m_Cmd.size());
+        if (2 == m_Cmd.size())
+        {
+            istringstream istr (m_Cmd[1]);
+            qUsage = ! (istr >> NbPas) || 0 == NbPas;
+        }
+        if (qUsage)
         {
-            cout << "Usage : step\n";
+            Erreur() << "Usage : step [nombre_de_pas]\n";
             return;
         }
 
         if (m_ProcInfo -> STATUS == ProcInfo::STAT_TERMINATED)
         {
-            cout << PROCENDED;
+            Erreur() << PROCENDED;
             return;
         }
 
-        cout << "Execution de la ligne n° "
+        if (1 < NbPas)
+        {
+            Avancer (ProcInfo::STEP_COUNT, NbPas, "step");
+            return;
+        }
+
+        m_Msg << "Execution de la ligne n° "
              << m_ProcInfo -> procData[m_Proc] -> nextLineNumber
              << '\n';
         m_ProcInfo -> avancerDUnPas (m_Proc);
-
-        for (vector<string>::iterator i (m_VarAAfficher.begin());
-             i < m_VarAAfficher.end(); ++i)
-            AfficherVar(*i);
+        Arret (SignalerWatch() ? "watchpoint" :
+               m_ProcInfo -> STATUS == ProcInfo::STAT_TERMINATED ? "exited"
+                                                                 : "step");
 
     } // GererStep()
 
+    void MiniDbg::GererNext () throw ()
+    {
+        if (1 != m_Cmd.size())
+        {
+            Erreur() << "Usage : next\n";
+            return;
+        }
+        Avancer (ProcInfo::STEP_OVER, 0, "next");
+
+    } // GererNext()
+
+    void MiniDbg::GererFinish () throw ()
+    {
+        if (1 != m_Cmd.size())
+        {
+            Erreur() << "Usage : finish\n";
+            return;
+        }
+        Avancer (ProcInfo::STEP_FINISH, 0, "finish");
+
+    } // GererFinish()
+
+    void MiniDbg::GererUntil () throw ()
+    {
+        unsigned numLigne (0);
+        if (2 == m_Cmd.size())
+        {
+            istringstream istr (m_Cmd[1]);
+            istr >> numLigne;
+            if (istr.fail()) numLigne = 0;
+        }
+        if (0 == numLigne)
+        {
+            Erreur() << "Usage : until <numero_ligne>\n";
+            return;
+        }
+
+        // comme pour break : une ligne sans instruction ne serait jamais
+        // atteinte
+        const ProcInfo::LineTable * Table (m_ProcInfo -> findLineTable (
+            m_ProcInfo -> procData[m_Proc] -> progName));
+        if (Table)
+        {
+            if (numLigne >= Table -> source.size() ||
+                0 > Table -> nextExec[numLigne])
+            {
+                Erreur() << "Numero de ligne invalide\n";
+                return;
+            }
+            numLigne = Table -> nextExec[numLigne];
+        }
+        Avancer (ProcInfo::STEP_UNTIL, numLigne, "until");
+
+    } // GererUntil()
+
+    // step <n>, next, finish et until : tous les pas sont faits par
+    // ProcInfo::stepTraced(), qui s'arrête aussi sur un breakpoint ou une
+    // écriture surveillée ; on ne revient au prompt qu'à la fin
+
+    void MiniDbg::Avancer (ProcInfo::StepMode Mode, unsigned long Arg,
+                           const char * Raison) throw ()
+    {
+        if (m_ProcInfo -> STATUS == ProcInfo::STAT_TERMINATED)
+        {
+            Erreur() << PROCENDED;
+            return;
+        }
+
+        const ProgBreaks & Breaks (
+            m_BreakBits[m_ProcInfo -> procData[m_Proc] -> progName]);
+        unsigned long NbPas;
+        const ProcInfo::StepStop Pourquoi (m_ProcInfo -> stepTraced (
+            m_Proc, Mode, Arg, &Breaks.m_Bits, &Breaks.m_Conds, &NbPas));
+        if (ProcInfo::STOP_NOLOOP == Pourquoi)
+        {
+            Erreur() << "Pas dans un WHILE\n";
+            return;
+        }
+        if (ProcInfo::STOP_INTERRUPT == Pourquoi) return; // une autre session
+                                                         // l'a détracé
+        if (ProcInfo::STOP_EXIT == Pourquoi)
+        {
+            Arret ("exited"); // la fin est déjà annoncée par ProcInfo
+            return;
+        }
+        if (ProcInfo::STOP_WATCH == Pourquoi)
+        {
+            SignalerWatch();
+            Arret ("watchpoint");
+            return;
+        }
+
+        const int Ligne (m_ProcInfo -> findCrtInstruction (
+            m_ProcInfo -> procData[m_Proc] -> proGram) -> lineNumber);
+        if (ProcInfo::STOP_CONDERROR == Pourquoi)
+            m_Msg << EVALFAILED " dans la condition\n";
+        if (ProcInfo::STOP_BREAK == Pourquoi ||
+            ProcInfo::STOP_CONDERROR == Pourquoi)
+        {
+            m_Msg << "Breakpoint à la ligne " << Ligne << " (" << NbPas
+                  << " pas)\n";
+            Arret (ProcInfo::STOP_CONDERROR == Pourquoi ? "condition-error"
+                                                       : "breakpoint");
+            return;
+        }
+        m_Msg << NbPas << " pas, ligne " << Ligne << '\n';
+        Arret (Raison);
+
+    } // Avancer()
+
+    // Les pas en arrière, sur le journal d'annulation du processus tracé :
+    // on ne peut pas revenir avant une entrée/sortie, un FORK ou un MUTEX
+
+    void MiniDbg::GererReverseStep () throw ()
+    {
+        unsigned NbPas (1);
+        bool     qUsage (2 < m_Cmd.size());
+        if (2 == m_Cmd.size())
+        {
+            istringstream istr (m_Cmd[1]);
+            qUsage = ! (istr >> NbPas) || 0 == NbPas;
+        }
+        if (qUsage)
+        {
+            Erreur() << "Usage : reverse-step [nombre_de_pas]\n";
+            return;
+        }
+
+        if (m_ProcInfo -> STATUS == ProcInfo::STAT_TERMINATED)
+        {
+            Erreur() << PROCENDED;
+            return;
+        }
+
+        string ErrMsg;
+        for (unsigned i(0); i < NbPas; ++i)
+            if (! m_ProcInfo -> undoStep (m_Proc, &ErrMsg))
+            {
+                (0 == i ? Erreur() : m_Msg) << ErrMsg << '\n';
+                if (0 == i) return;
+                break;
+            }
+
+        m_Msg << "Retour à la ligne "
+             << m_ProcInfo -> findCrtInstruction (
+                    m_ProcInfo -> procData[m_Proc] -> proGram) -> lineNumber
+             << '\n';
+        Arret ("reverse-step");
+
+    } // GererReverseStep()
+
+    void MiniDbg::GererReverseContinue () throw ()
+    {
+        if (1 != m_Cmd.size())
+        {
+            Erreur() << "Usage : reverse-continue\n";
+            return;
+        }
+
+        if (m_ProcInfo -> STATUS == ProcInfo::STAT_TERMINATED)
+        {
+            Erreur() << PROCENDED;
+            return;
+        }
+
+        const ProgBreaks & Breaks (
+            m_BreakBits[m_ProcInfo -> procData[m_Proc] -> progName]);
+        const vector<bool> & Bits (Breaks.m_Bits);
+
+        string ErrMsg;
+        unsigned NbPas (0);
+        for (; m_ProcInfo -> undoStep (m_Proc, &ErrMsg); ++NbPas)
+        {
+            const unsigned Ligne (m_ProcInfo -> findCrtInstruction(
+                m_ProcInfo -> procData[m_Proc] -> proGram) -> lineNumber);
+            bool qEchec;
+            if (Ligne < Bits.size() && Bits[Ligne] &&
+                m_ProcInfo -> evalCond (m_Proc, Breaks.m_Conds[Ligne],
+                                        &qEchec))
+            {
+                if (qEchec) m_Msg << EVALFAILED " dans la condition\n";
+                m_Msg << "Breakpoint à la ligne " << Ligne << " ("
+                     << NbPas + 1 << " pas en arrière)\n";
+                Arret (qEchec ? "condition-error" : "breakpoint");
+                return;
+            }
+        }
+        m_Msg << ErrMsg << " (" << NbPas << " pas en arrière), ligne "
+             << m_ProcInfo -> findCrtInstruction (
+                    m_ProcInfo -> procData[m_Proc] -> proGram) -> lineNumber
+             << '\n';
+        Arret ("log-start");
+
+    } // GererReverseContinue()
+
     void MiniDbg::GererPrint () throw ()
     {
-        if (2 != m_Cmd.size())
+        if (2 > m_Cmd.size())
         {
-            cout << "Usage : print <nom_variable>\n";
+            Erreur() << "Usage : print <expression>\n";
             return;
         }
 
-        AfficherVar (m_Cmd[1]);
+        AfficherExpr (TexteExpr (1));
 
     } // GererPrint()
 
     void MiniDbg::GererDisplay () throw ()
     {
-        if (2 != m_Cmd.size())
+        if (2 > m_Cmd.size())
         {
-            cout << "Usage : print <nom_variable>\n";
+            Erreur() << "Usage : display <expression>\n";
             return;
         }
 
-        if (! AfficherVar(m_Cmd[1])) // AfficherVar renvoie 0 si on a réussi
-            m_VarAAfficher.push_back(m_Cmd[1]);
+        Affichage Aff;
+        Aff.m_Texte = TexteExpr (1);
+        Aff.m_Nom   = NomExpr (Aff.m_Texte);
+        string ErrMsg;
+        Aff.m_qResolue = m_ProcInfo -> compileExpr (m_Proc, Aff.m_Texte,
+                                                    &Aff.m_Expr, &ErrMsg);
+        if (! Aff.m_qResolue)
+        {
+            Erreur() << ErrMsg << '\n';
+            return;
+        }
+        m_Display.push_back(Aff);
+        // sa valeur tout de suite, comme aux arrêts suivants
+        AfficherUnDisplay (m_Sortie, Aff);
 
     } // GererDisplay()
 
@@ -222,7 +675,7 @@ namespace ProcDebug
     {
         if (3 != m_Cmd.size())
         {
-            cout << "Usage : modifiy <variable> <valeur>\n";
+            Erreur() << "Usage : modifiy <variable> <valeur>\n";
             return;
         }
 
@@ -232,7 +685,7 @@ namespace ProcDebug
             istr >> Val;
             if (istr.fail())
             {
-                cout << "Usage : modifiy <variable> <valeur>\n";
+                Erreur() << "Usage : modifiy <variable> <valeur>\n";
                 return;
             }
         }
@@ -243,13 +696,15 @@ namespace ProcDebug
 
         if (-1 == Indice)
         {
-            cerr << "Variable introuvable\n";
+            Erreur() << "Variable introuvable\n";
             return;
         }
 
         m_ProcInfo -> procData[m_Proc] -> symbolTable[Indice] . value = Val;
+        // les pas journalisés ne savent rien de cette valeur
+        m_ProcInfo -> forgetUndo (m_Proc);
 
-        cout << m_ProcInfo -> procData[m_Proc] -> symbolTable[Indice] . varIdent
+        m_Msg << m_ProcInfo -> procData[m_Proc] -> symbolTable[Indice] . varIdent
              << " = "
              << m_ProcInfo -> procData[m_Proc] -> symbolTable[Indice] . value
              << '\n';
@@ -260,9 +715,9 @@ namespace ProcDebug
     {
         // Beaucoups de tests avant d'ajouter le breakpoint au vecteur...
 
-        if (2 != m_Cmd.size())
+        if (2 != m_Cmd.size() && (4 > m_Cmd.size() || m_Cmd[2] != "if"))
         {
-            cout << "Usage : break <numero_ligne>\n";
+            Erreur() << "Usage : break <numero_ligne> [if <expression>]\n";
             return;
         }
 
@@ -273,76 +728,639 @@ namespace ProcDebug
             istr >> numLigne;
             if (istr.fail())
             {
-                cout << "Usage : break <numero_ligne>\n";
+                Erreur() << "Usage : break <numero_ligne>\n";
                 return;
             }
         }
 
-        // Comptage des lignes du fichier
-        unsigned maxNbLignes (0);
-        ifstream fic (m_ProcInfo -> procData[m_Proc] -> progName .c_str());
-        // en une seule ligne s'il vous plaît ^_^
-        for (string Str; ! getline(fic, Str).eof(); ++maxNbLignes);
-        fic.close();
+        const string & ProgName (m_ProcInfo -> procData[m_Proc] -> progName);
+        const ProcInfo::LineTable * Table (ResoudreLigne (&numLigne,
+                                                          "breakpoint"));
+        if (! Table) return;
 
-        if (0 >= numLigne || numLigne > maxNbLignes)
+        // On vérifie si le breakpoint n'existe pas déjà
+        ProgBreaks & Breaks (m_BreakBits[ProgName]);
+        if (numLigne < Breaks.m_Bits.size() && Breaks.m_Bits[numLigne])
         {
-            cout << "Numero de ligne invalide\n";
+            Erreur() << "Breakpoint déjà enregistré\n";
             return;
         }
 
-        // On vérifie si le breakpoint n'existe pas déjà
-        for (vector<int>::iterator i (m_Break.begin());
-             i < m_Break.end(); ++i)
-            if ((int) numLigne == *i)
+        // La condition, compilée une fois pour toutes
+        string CondStr;
+        ProcInfo::CompiledCond Cond;
+        if (m_Cmd.size() > 2)
+        {
+            for (unsigned i(3); i < m_Cmd.size(); ++i)
+                CondStr += (i > 3 ? " " : "") + m_Cmd[i];
+            string ErrMsg;
+            if (! m_ProcInfo -> compileExpr (m_Proc, CondStr, &Cond, &ErrMsg))
             {
-                cout << "Breakpoint déjà enregistré\n";
+                Erreur() << ErrMsg << '\n';
                 return;
             }
+        }
 
         if ((int)numLigne == m_ProcInfo -> findCrtInstruction (
                   m_ProcInfo -> procData[m_Proc] -> proGram) -> lineNumber)
-            cout << "Ce breakpoint pointe sur la ligne suivante "
+            m_Msg << "Ce breakpoint pointe sur la ligne suivante "
                  << "qui est déjà interrompue !\nIl sera donc ignoré "
-                 << "pour cette exécution\n";
+                 << "jusqu'au prochain passage\n";
 
 
         // pfiou...
-        m_Break.push_back(numLigne);
-        cout << '[' << m_Break.size() << "] ligne n° " << numLigne << '\n';
-        sort(m_Break.begin(), m_Break.end()); // histoire de
+        if (Breaks.m_Bits.size() <= numLigne)
+        {
+            Breaks.m_Bits.resize  (Table -> source.size());
+            Breaks.m_Conds.resize (Table -> source.size());
+        }
+        Breaks.m_Bits [numLigne] = true;
+        Breaks.m_Conds[numLigne] = Cond;
+        BreakPoint Bp;
+        Bp.m_ProgName = ProgName;
+        Bp.m_Ligne    = numLigne;
+        Bp.m_Cond     = CondStr;
+        m_Break.push_back(Bp);
+        m_Msg << '[' << m_Break.size() << "] ligne n° " << numLigne;
+        if (! CondStr.empty()) m_Msg << " si " << CondStr;
+        m_Msg << '\n';
 
     } // GererBreak()
 
+    // La table des lignes, faite au chargement du programme : une ligne
+    // sans instruction (vide, ENDWHILE...) ne serait jamais atteinte, on
+    // prend la suivante qui en a une ; 0 si aucune ne convient
+
+    const ProcInfo::LineTable * MiniDbg::ResoudreLigne (unsigned * pLigne,
+                                                       const char * Quoi)
+        throw ()
+    {
+        const ProcInfo::LineTable * Table (m_ProcInfo -> findLineTable (
+                               m_ProcInfo -> procData[m_Proc] -> progName));
+        if (! Table || 0 >= *pLigne || *pLigne >= Table -> source.size() ||
+            0 > Table -> nextExec[*pLigne])
+        {
+            Erreur() << "Numero de ligne invalide\n";
+            return 0;
+        }
+        if ((int)*pLigne != Table -> nextExec[*pLigne])
+        {
+            m_Msg << "Pas d'instruction à la ligne " << *pLigne
+                  << ", " << Quoi << " à la ligne "
+                  << Table -> nextExec[*pLigne] << '\n';
+            *pLigne = Table -> nextExec[*pLigne];
+        }
+        return Table;
+
+    } // ResoudreLigne()
+
+    // trace <ligne> <var>... : comme un breakpoint, mais qui n'arrête
+    // personne ; les valeurs vont dans l'anneau de ProcInfo, que tdump
+    // (et la fin de l'exécution) affiche
+
+    void MiniDbg::GererTrace () throw ()
+    {
+        if (3 > m_Cmd.size())
+        {
+            Erreur() << "Usage : trace <numero_ligne> <var>...\n";
+            return;
+        }
+
+        unsigned numLigne;
+        {
+            istringstream istr (m_Cmd[1]);
+            istr >> numLigne;
+            if (istr.fail())
+            {
+                Erreur() << "Usage : trace <numero_ligne> <var>...\n";
+                return;
+            }
+        }
+        if (! ResoudreLigne (&numLigne, "tracepoint")) return;
+
+        string ErrMsg;
+        const int Num (m_ProcInfo -> addTracePoint (m_Proc, numLigne,
+                           vector<string> (m_Cmd.begin() + 2, m_Cmd.end()),
+                           &ErrMsg));
+        if (-1 == Num)
+        {
+            Erreur() << ErrMsg << '\n';
+            return;
+        }
+        m_Msg << '[' << Num + 1 << "] ligne n° " << numLigne;
+        for (unsigned i(2); i < m_Cmd.size(); ++i) m_Msg << ' ' << m_Cmd[i];
+        m_Msg << '\n';
+
+    } // GererTrace()
+
+    void MiniDbg::GererTdump () throw ()
+    {
+        if (1 != m_Cmd.size())
+        {
+            Erreur() << "Usage : tdump\n";
+            return;
+        }
+        m_ProcInfo -> dumpTrace (&m_Sortie, m_qMachine);
+
+    } // GererTdump()
+
+    // un indice de watch ou de x : un nombre ou une variable du processus
+
+    bool MiniDbg::ValeurIndice (const string & Texte, int * pValeur) throw ()
+    {
+        istringstream istr (Texte);
+        if ((istr >> *pValeur) && istr.eof()) return true;
+
+        ProcInfo::ProcData * Data (m_ProcInfo -> procData[m_Proc]);
+        const int Sym (Data -> findExistentSymbol(Texte));
+        if (-1 == Sym)
+        {
+            Erreur() << "Indice invalide " << Texte << '\n';
+            return false;
+        }
+        *pValeur = Data -> symbolTable[Sym] . value;
+        return true;
+
+    } // ValeurIndice()
+
+    // d : décimal, u : non signé, x : hexadécimal, o : octal, c : caractère
+    // (le code, s'il ne s'affiche pas)
+
+    void MiniDbg::AfficherCase (int Valeur, char Format) throw ()
+    {
+        switch (Format)
+        {
+          case 'u' : m_Sortie << (unsigned) Valeur; break;
+          case 'x' : m_Sortie << "0x" << hex << (unsigned) Valeur << dec;
+                     break;
+          case 'o' : m_Sortie << '0' << oct << (unsigned) Valeur << dec;
+                     break;
+          case 'c' :
+              if (0 < Valeur && Valeur < 128 && isprint (Valeur))
+                  m_Sortie << '\'' << (char) Valeur << '\'';
+              else
+                  m_Sortie << Valeur;
+              break;
+          default  : m_Sortie << Valeur;
+        }
+
+    } // AfficherCase()
+
+    // x <base>$<début>[..<fin>] [d|u|x|o|c] : les cases <début> à <fin>
+    // (comprises) du tas à partir de la valeur de la variable <base>
+    // (comme LOAD), du tas tout court si <base> est vide, ou de la
+    // mémoire partagée si c'est _ ; une valeur répétée au moins
+    // REPETITION fois n'est affichée qu'une fois, avec son nombre
+
+    void MiniDbg::GererX () throw ()
+    {
+        const string Formats ("duxoc");
+        if ((2 != m_Cmd.size() && 3 != m_Cmd.size()) ||
+            (3 == m_Cmd.size() && (1 != m_Cmd[2].size() ||
+                                   string::npos == Formats.find(m_Cmd[2][0]))))
+        {
+            Erreur() << "Usage : x <var>$<debut>[..<fin>] | _$<debut>[..<fin>]"
+                     << " [d|u|x|o|c]\n";
+            return;
+        }
+        const char Format (3 == m_Cmd.size() ? m_Cmd[2][0] : 'd');
+
+        const string & Texte (m_Cmd[1]);
+        const string::size_type Dollar (Texte.find('$'));
+        if (string::npos == Dollar)
+        {
+            Erreur() << "Usage : x <var>$<debut>[..<fin>] | _$<debut>[..<fin>]"
+                     << " [d|u|x|o|c]\n";
+            return;
+        }
+        const string Base  (Texte.substr(0, Dollar));
+        const string Plage (Texte.substr(Dollar + 1));
+        const string::size_type Points (Plage.find(".."));
+        int Debut, Fin;
+        if (! ValeurIndice (Plage.substr(0, Points), &Debut)) return;
+        if (string::npos == Points) Fin = Debut;
+        else if (! ValeurIndice (Plage.substr(Points + 2), &Fin)) return;
+        if (Fin < Debut)
+        {
+            Erreur() << "Plage vide\n";
+            return;
+        }
+
+        ProcInfo::ProcData * Data (m_ProcInfo -> procData[m_Proc]);
+        const vector<int> * Memoire (&Data -> heapMemory);
+        int Origine (0);
+        if (Base == "_")
+        {
+            Memoire = &m_ProcInfo -> sharedMemory;
+            Origine = m_ProcInfo -> sharedMemoryBase;
+        }
+        else if (! Base.empty())
+        {
+            const int Sym (Data -> findExistentSymbol(Base));
+            if (-1 == Sym)
+            {
+                Erreur() << "Variable introuvable\n";
+                return;
+            }
+            Origine = Data -> symbolTable[Sym] . value;
+        }
+        if (0 > Origine + Debut || Origine + Fin >= (int) Memoire -> size())
+        {
+            Erreur() << "Case hors de la mémoire\n";
+            return;
+        }
+
+        // ParLigne groupes par ligne, chacune commençant par sa case
+        const unsigned REPETITION (4);
+        const unsigned ParLigne (8);
+        const int * Cases (&(*Memoire)[Origine]);
+        unsigned NbGroupes (0);
+        for (int i (Debut); i <= Fin; )
+        {
+            int j (i + 1);
+            while (j <= Fin && Cases[j] == Cases[i]) ++j;
+            const unsigned Nb (j - i < (int) REPETITION ? 1 : j - i);
+            if (0 == NbGroupes++ % ParLigne)
+            {
+                if (i != Debut) m_Sortie << '\n';
+                if (m_qMachine)
+                    m_Sortie << "@mem pid=" << m_Proc + 1 << " cell="
+                             << Base << '$' << i << " values=";
+                else
+                    m_Sortie << Base << '$' << i << " :";
+            }
+            else if (m_qMachine) m_Sortie << ',';
+            if (! m_qMachine) m_Sortie << ' ';
+            AfficherCase (Cases[i], Format);
+            if (1 < Nb)
+            {
+                if (m_qMachine) m_Sortie << '*' << Nb;
+                else            m_Sortie << " <" << Nb << " fois>";
+            }
+            i += Nb;
+        }
+        m_Sortie << '\n';
+
+    } // GererX()
+
+    // xdiff [d|u|x|o|c] : les cases du tas du processus ($<case>, comme
+    // x sans base) et de la mémoire partagée qui ont changé entre les
+    // deux derniers arrêts ; des cases voisines qui sont passées de la
+    // même valeur à la même valeur ne font qu'une ligne, et il n'y en a
+    // pas plus de XDIFF_MAX (sauf en mode machine)
+
+    void MiniDbg::GererXdiff () throw ()
+    {
+        const string Formats ("duxoc");
+        if (2 < m_Cmd.size() ||
+            (2 == m_Cmd.size() && (1 != m_Cmd[1].size() ||
+                                   string::npos == Formats.find(m_Cmd[1][0]))))
+        {
+            Erreur() << "Usage : xdiff [d|u|x|o|c]\n";
+            return;
+        }
+        const char Format (2 == m_Cmd.size() ? m_Cmd[1][0] : 'd');
+
+        vector<ProcInfo::MemChange> Changes;
+        m_ProcInfo -> diffMemory (m_Proc, &Changes);
+        const unsigned XDIFF_MAX (32);
+        unsigned NbLignes (0);
+        for (unsigned i (0), j; i < Changes.size(); i = j)
+        {
+            const ProcInfo::MemChange & Change (Changes[i]);
+            for (j = i + 1; j < Changes.size() &&
+                     Changes[j].qShared  == Change.qShared &&
+                     Changes[j].cell     == Changes[j-1].cell + 1 &&
+                     Changes[j].oldValue == Change.oldValue &&
+                     Changes[j].newValue == Change.newValue; ++j) ;
+            const char * Base (Change.qShared ? "_" : "");
+            const int Origine (Change.qShared ? m_ProcInfo -> sharedMemoryBase
+                                              : 0);
+            if (m_qMachine)
+            {
+                m_Sortie << "@diff pid=" << m_Proc + 1 << " cell=" << Base
+                         << '$' << Change.cell - Origine << " count="
+                         << j - i << " old=";
+                AfficherCase (Change.oldValue, Format);
+                m_Sortie << " new=";
+                AfficherCase (Change.newValue, Format);
+                m_Sortie << '\n';
+                continue;
+            }
+            if (XDIFF_MAX == NbLignes++)
+            {
+                m_Sortie << "... et " << Changes.size() - i
+                         << " autre(s) case(s)\n";
+                return;
+            }
+            m_Sortie << Base << '$' << Change.cell - Origine;
+            if (1 < j - i)
+                m_Sortie << ".." << Changes[j-1].cell - Origine;
+            m_Sortie << " : ";
+            AfficherCase (Change.oldValue, Format);
+            m_Sortie << " -> ";
+            AfficherCase (Change.newValue, Format);
+            m_Sortie << '\n';
+        }
+        if (Changes.empty() && ! m_qMachine)
+            m_Msg << "Aucune case modifiée\n";
+
+    } // GererXdiff()
+
+    // watch <var>, watch <var>$<indice> (tas du processus, à l'adresse
+    // var + indice comme pour LOAD/STORE) et watch _$<indice> (mémoire
+    // partagée) ; l'indice est un nombre ou une variable
+
+    void MiniDbg::GererWatch () throw ()
+    {
+        if (2 != m_Cmd.size())
+        {
+            Erreur() << "Usage : watch <var> | <var>$<indice> | _$<indice>\n";
+            return;
+        }
+
+        ProcInfo::ProcData * Data (m_ProcInfo -> procData[m_Proc]);
+        const string & Texte (m_Cmd[1]);
+        const string::size_type Dollar (Texte.find('$'));
+        WatchPoint Wp;
+        Wp.m_Proc  = m_Proc;
+        Wp.m_Texte = Texte;
+
+        if (string::npos == Dollar)
+        {
+            Wp.m_Kind = ProcInfo::WATCH_SYMBOL;
+            if (-1 == (Wp.m_Cell = Data -> findExistentSymbol(Texte)))
+            {
+                Erreur() << "Variable introuvable\n";
+                return;
+            }
+        }
+        else
+        {
+            const string Base   (Texte.substr(0, Dollar));
+            const string Indice (Texte.substr(Dollar + 1));
+            int ValIndice;
+            if (! ValeurIndice (Indice, &ValIndice)) return;
+            int Limite;
+            if (Base == "_")
+            {
+                Wp.m_Kind  = ProcInfo::WATCH_SHARED;
+                Wp.m_Cell  = m_ProcInfo -> sharedMemoryBase + ValIndice;
+                Limite     = m_ProcInfo -> sharedMemory.size();
+            }
+            else
+            {
+                const int Sym (Data -> findExistentSymbol(Base));
+                if (-1 == Sym)
+                {
+                    Erreur() << "Variable introuvable\n";
+                    return;
+                }
+                Wp.m_Kind  = ProcInfo::WATCH_HEAP;
+                Wp.m_Cell  = Data -> symbolTable[Sym] . value + ValIndice;
+                Limite     = Data -> heapMemory.size();
+            }
+            if (Wp.m_Cell < 0 || Wp.m_Cell >= Limite)
+            {
+                Erreur() << "Case hors de la mémoire\n";
+                return;
+            }
+        }
+
+        if (! m_ProcInfo -> setWatch (m_Proc, Wp.m_Kind, Wp.m_Cell, true))
+        {
+            Erreur() << "Watchpoint déjà enregistré\n";
+            return;
+        }
+        m_Watch.push_back(Wp);
+        m_Msg << '[' << m_Watch.size() << "] " << Texte << '\n';
+
+    } // GererWatch()
+
+    bool MiniDbg::SignalerWatch () throw ()
+    {
+        ProcInfo::WatchHit & Hit (m_ProcInfo -> watchHit);
+        if (ProcInfo::invalidProcPid == Hit.procPid) return false;
+
+        // le texte du watchpoint correspondant, pour l'affichage
+        string Texte ("?");
+        for (unsigned i(0); i < m_Watch.size(); ++i)
+            if (m_Watch[i].m_Kind == Hit.kind && m_Watch[i].m_Cell == Hit.cell
+                && (Hit.kind == ProcInfo::WATCH_SHARED ||
+                    m_Watch[i].m_Proc == Hit.procPid))
+            {
+                Texte = m_Watch[i].m_Texte;
+                break;
+            }
+        if (m_qMachine)
+            m_Sortie << "@watch name=" << Texte << " old=" << Hit.oldValue
+                 << " new=" << Hit.newValue << " pid=" << Hit.procPid + 1
+                 << " prog=" << Hit.fileName << " line=" << Hit.lineNumber
+                 << '\n';
+        else
+            m_Sortie << "\nWatchpoint " << Texte << " : " << Hit.oldValue
+                 << " -> " << Hit.newValue << " par le processus "
+                 << Hit.procPid + 1 << " (" << Hit.fileName << " ligne "
+                 << Hit.lineNumber << ")\n";
+        Hit.procPid = ProcInfo::invalidProcPid;
+        return true;
+
+    } // SignalerWatch()
+
+    void MiniDbg::GererCheckpoint () throw ()
+    {
+        if (2 != m_Cmd.size())
+        {
+            Erreur() << "Usage : checkpoint <fichier>\n";
+            return;
+        }
+
+        try
+        {
+            Checkpoint::save (*m_ProcInfo, m_Cmd[1]);
+            m_Msg << "Etat sauvé dans " << m_Cmd[1] << '\n';
+        }
+        catch (const CExc & Exc)
+        {
+            Erreur() << Exc << '\n';
+        }
+
+    } // GererCheckpoint()
+
+    // Le restore remplace toute la table des processus : on ne le fait
+    // pas au milieu d'un tick (on peut être arrivé ici entre l'élection
+    // d'un processus et son pas), mais dans la boucle principale, qui
+    // relance ensuite le débugger sur le processus tracé
+
+    void MiniDbg::GererRestore () throw ()
+    {
+        if (2 != m_Cmd.size())
+        {
+            Erreur() << "Usage : restore <fichier>\n";
+            return;
+        }
+        // le journal rejoue depuis le début : un restore au milieu
+        // ne se rejouerait pas
+        if (m_ProcInfo -> journal && (m_ProcInfo -> journal -> qRecording()
+                                      || m_ProcInfo -> journal -> qReplaying()))
+        {
+            Erreur() << "Pas de restore avec --record ou --replay\n";
+            return;
+        }
+
+        // les watchpoints sur un processus ne survivent pas à la
+        // restauration, ceux sur la mémoire partagée si
+        for (unsigned i(m_Watch.size()); i--; )
+            if (m_Watch[i].m_Kind != ProcInfo::WATCH_SHARED)
+            {
+                m_Msg << "Suppression du watchpoint [" << i+1 << "] "
+                     << m_Watch[i].m_Texte << '\n';
+                m_ProcInfo -> setWatch (m_Watch[i].m_Proc, m_Watch[i].m_Kind,
+                                        m_Watch[i].m_Cell, false);
+                m_Watch.erase(m_Watch.begin() + i);
+            }
+
+        m_Restore = m_Cmd[1];
+        m_Msg << "Restauration de " << m_Restore << " avant le prochain tick\n";
+        m_GoOut = true;
+
+    } // GererRestore()
+
+    bool MiniDbg::PrendreRestore (string * File) throw ()
+    {
+        if (m_Restore.empty()) return false;
+        File -> swap(m_Restore);
+        m_Restore.clear();
+        return true;
+
+    } // PrendreRestore()
+
+    void MiniDbg::SignalerErreur (const string & Texte) throw ()
+    {
+        Erreur() << Texte << '\n';
+        SignalerEchec();
+
+    } // SignalerErreur()
+
+    // list [<ligne> [<nombre>]] : le source, pris dans la table des
+    // lignes du programme ; "=>" marque la ligne courante et "*" un
+    // breakpoint. sans argument, autour de la ligne courante, puis à la
+    // suite de ce qui vient d'être listé
+
+    void MiniDbg::GererList () throw ()
+    {
+        int Debut (m_ListeSuite), Nb (10);
+        if (3 < m_Cmd.size())
+        {
+            Erreur() << "Usage : list [<numero_ligne> [<nombre>]]\n";
+            return;
+        }
+        if (1 < m_Cmd.size())
+        {
+            istringstream istr (m_Cmd[1] + (3 == m_Cmd.size()
+                                            ? " " + m_Cmd[2] : ""));
+            istr >> Debut;
+            if (3 == m_Cmd.size()) istr >> Nb;
+            if (istr.fail() || 0 > Debut || 0 >= Nb)
+            {
+                Erreur() << "Usage : list [<numero_ligne> [<nombre>]]\n";
+                return;
+            }
+        }
+
+        const ProcInfo::ProcData * Data (m_ProcInfo -> procData[m_Proc]);
+        const ProcInfo::LineTable * Table (
+            m_ProcInfo -> findLineTable (Data -> progName));
+        if (! Table)
+        {
+            Erreur() << "Source introuvable\n";
+            return;
+        }
+        const int Courante (Data -> procStatus == ProcInfo::STAT_TERMINATED
+            ? -1
+            : m_ProcInfo -> findCrtInstruction (Data -> proGram) -> lineNumber);
+        if (0 > Debut) Debut = max (0, Courante - Nb / 2);
+        const int Fin (min (Debut + Nb, (int)Table -> source.size()));
+        if (Debut >= Fin)
+        {
+            Erreur() << "Fin du fichier\n";
+            return;
+        }
+
+        const BreakBits_t::const_iterator Breaks (
+            m_BreakBits.find (Data -> progName));
+        for (int k (Debut); k < Fin; ++k)
+        {
+            if (m_qMachine)
+            {
+                m_Sortie << "@source line=" << k << " text="
+                     << Table -> source[k] << '\n';
+                continue;
+            }
+            const bool qBreak (Breaks != m_BreakBits.end() &&
+                               k < (int)Breaks -> second.m_Bits.size() &&
+                               Breaks -> second.m_Bits[k]);
+            m_Msg << (k == Courante ? "=>" : "  ") << (qBreak ? '*' : ' ')
+                  << setw (4) << k << "  " << Table -> source[k] << '\n';
+        }
+        m_ListeSuite = Fin;
+
+    } // GererList()
+
     void MiniDbg::GererShow () throw ()
     {
         if (2 != m_Cmd.size())
         {
-            cout << "Usage : show <quoi>\n";
+            Erreur() << "Usage : show <quoi>\n";
             return;
         }
 
         if (m_Cmd[1] == "display")
         {
-            for (unsigned i(0); i < m_VarAAfficher.size(); ++i)
+            for (unsigned i(0); i < m_Display.size(); ++i)
             {
-                cout << '[' << i+1 << "] "; // numéro, celui à spécifier
-                                            // si on veux supprimer
-                AfficherVar(m_VarAAfficher[i]);
+                if (! m_qMachine) // numéro, celui à spécifier si on
+                    m_Msg << '[' << i+1 << "] "; // veux supprimer
+                AfficherUnDisplay (m_Sortie, m_Display[i]);
             }
         }
         else if (m_Cmd[1] == "break")
         {
             for (unsigned i(0); i < m_Break.size(); ++i)
-                cout << '[' << i+1 << "] ligne n° " << m_Break[i] << '\n';
+            {
+                m_Msg << '[' << i+1 << "] ligne n° " << m_Break[i].m_Ligne;
+                if (! m_Break[i].m_Cond.empty())
+                    m_Msg << " si " << m_Break[i].m_Cond;
+                m_Msg << " (" << m_Break[i].m_ProgName << ")\n";
+            }
+        }
+        else if (m_Cmd[1] == "watch")
+        {
+            for (unsigned i(0); i < m_Watch.size(); ++i)
+                m_Msg << '[' << i+1 << "] " << m_Watch[i].m_Texte
+                     << " (processus " << m_Watch[i].m_Proc + 1 << ")\n";
+        }
+        else if (m_Cmd[1] == "trace")
+        {
+            const vector<ProcInfo::TracePoint> & Points (
+                m_ProcInfo -> tracePoints);
+            for (unsigned i(0); i < Points.size(); ++i)
+            {
+                if (0 > Points[i].lineNumber) continue; // supprimé
+                m_Msg << '[' << i+1 << "] ligne n° " << Points[i].lineNumber;
+                for (unsigned k(0); k < Points[i].names.size(); ++k)
+                    m_Msg << ' ' << Points[i].names[k];
+                m_Msg << " (" << Points[i].progName << ")\n";
+            }
         }
         else if (m_Cmd[1] == "proc")
         {
             for (unsigned i(0); i < m_ProcInfo->procData.size(); ++i)
-                cout << '[' << i+1 << "] "
-                     << m_ProcInfo -> procData[i] -> progName << endl;
+                if (m_ProcInfo -> procData[i]) // sinon pid libre
+                    m_Msg << '[' << i+1 << "] "
+                         << m_ProcInfo -> procData[i] -> progName << endl;
         }
-        else cout << "<quoi> invalide\n";
+        else Erreur() << "<quoi> invalide\n";
 
     } // GererShow()
 
@@ -350,7 +1368,7 @@ namespace ProcDebug
     {
         if (3 != m_Cmd.size())
         {
-            cout << "Usage : remove <quoi> <n°>\n";
+            Erreur() << "Usage : remove <quoi> <n°>\n";
             return;
         }
 
@@ -365,31 +1383,59 @@ namespace ProcDebug
 
         if (m_Cmd[1] == "display")
         {
-            if (Num >= m_VarAAfficher.size())
+            if (Num >= m_Display.size())
             {
-                cout << "Indice incorrect\n";
+                Erreur() << "Indice incorrect\n";
                 return;
             }
 
-            cout << "Suppression de la variable \""
-                 << *(m_VarAAfficher.begin() + Num)
+            m_Msg << "Suppression de l'expression \""
+                 << m_Display[Num].m_Nom
                  << "\" à afficher\n";
-            m_VarAAfficher.erase(m_VarAAfficher.begin() + Num);
+            m_Display.erase(m_Display.begin() + Num);
         }
         else if (m_Cmd[1] == "break")
         {
             if (Num >= m_Break.size())
             {
-                cout << "Indice incorrect\n";
+                Erreur() << "Indice incorrect\n";
                 return;
             }
 
-            cout << "Suppression du breakpoint [" << Num+1 // a cause du --Num
+            m_Msg << "Suppression du breakpoint [" << Num+1 // a cause du --Num
                  << "] à la ligne n° "
-                 << *(m_Break.begin() + Num) << '\n';
+                 << m_Break[Num].m_Ligne << '\n';
+            ProgBreaks & Breaks (m_BreakBits[m_Break[Num].m_ProgName]);
+            Breaks.m_Bits [m_Break[Num].m_Ligne] = false;
+            Breaks.m_Conds[m_Break[Num].m_Ligne] = ProcInfo::CompiledCond();
             m_Break.erase(m_Break.begin() + Num);
         }
-        else cout << "<quoi> invalide\n";
+        else if (m_Cmd[1] == "watch")
+        {
+            if (Num >= m_Watch.size())
+            {
+                Erreur() << "Indice incorrect\n";
+                return;
+            }
+
+            m_Msg << "Suppression du watchpoint [" << Num+1 << "] "
+                 << m_Watch[Num].m_Texte << '\n';
+            m_ProcInfo -> setWatch (m_Watch[Num].m_Proc, m_Watch[Num].m_Kind,
+                                    m_Watch[Num].m_Cell, false);
+            m_Watch.erase(m_Watch.begin() + Num);
+        }
+        else if (m_Cmd[1] == "trace")
+        {
+            // pas d'effacement : les numéros restent ceux des
+            // enregistrements déjà dans l'anneau
+            if (! m_ProcInfo -> removeTracePoint (Num))
+            {
+                Erreur() << "Indice incorrect\n";
+                return;
+            }
+            m_Msg << "Suppression du tracepoint [" << Num+1 << "]\n";
+        }
+        else Erreur() << "<quoi> invalide\n";
 
     } // GererRemove()
 
@@ -397,7 +1443,7 @@ namespace ProcDebug
     {
         if (m_ProcInfo -> STATUS == ProcInfo::STAT_TERMINATED)
         {
-            cout << PROCENDED;
+            Erreur() << PROCENDED;
             return;
         }
 
@@ -409,19 +1455,19 @@ namespace ProcDebug
     {
         if (2 < m_Cmd.size())
         {
-            cout << "Usage : start <step | >\n";
+            Erreur() << "Usage : start <step | >\n";
             return;
         }
         else
             if (2 == m_Cmd.size() && m_Cmd[1] != "step")
             {
-                cout << "Usage : start <step | >\n";
+                Erreur() << "Usage : start <step | >\n";
                 return;
             }
 
         if (m_ProcInfo -> STATUS != ProcInfo::STAT_TERMINATED)
         {
-            cout << "Processus non terminé\n";
+            Erreur() << "Processus non terminé\n";
             return;
         }
 
@@ -450,13 +1496,13 @@ namespace ProcDebug
     {
         if (2 < m_Cmd.size())
         {
-            cout << "Usage : start <step | >\n";
+            Erreur() << "Usage : start <step | >\n";
             return;
         }
         else
             if (2 == m_Cmd.size() && m_Cmd[1] != "step")
             {
-                cout << "Usage : start <step | >\n";
+                Erreur() << "Usage : start <step | >\n";
                 return;
             }
 
@@ -469,7 +1515,7 @@ namespace ProcDebug
     {
         if (2 != m_Cmd.size())
         {
-            cout << "Usage : changeproc <pid>\n";
+            Erreur() << "Usage : changeproc <pid>\n";
             return;
         }
 
@@ -479,31 +1525,67 @@ namespace ProcDebug
             istr >> numProc;
             if (istr.fail())
             {
-                cout << "Usage : changeproc <pid>\n";
+                Erreur() << "Usage : changeproc <pid>\n";
                 return;
             }
         }
         --numProc; // Pour les mêmes raisons que avant...
 
-        if (numProc >= m_ProcInfo -> procData.size() ||
-            numProc < 0)
+        if (numProc >= m_ProcInfo -> procData.size() || // 0 aussi
+            !m_ProcInfo -> procData[numProc]) // fils termine et libere
         {
-            cout << "Indice invalide\n";
+            Erreur() << "Indice invalide\n";
             return;
         }
 
         m_Proc = numProc;
-        if (m_ProcInfo -> STATUS != ProcInfo::STAT_TRACEEND &&
+        ResoudreDisplay();
+        // en non-stop, on le regarde sans l'arrêter (voir interrupt)
+        if (! m_qNonStop &&
+            m_ProcInfo -> STATUS != ProcInfo::STAT_TRACEEND &&
             m_ProcInfo -> STATUS != ProcInfo::STAT_TERMINATED)
-            m_ProcInfo -> updateProcData(m_Proc, ProcInfo::START_TRACE);
+            Tracer (m_Proc);
 
     } // GererChangeProc()
 
+    // Non-stop : arrête le processus choisi par changeproc
+
+    void MiniDbg::GererInterrupt () throw ()
+    {
+        if (1 != m_Cmd.size())
+        {
+            Erreur() << "Usage : interrupt\n";
+            return;
+        }
+        if (! m_qNonStop)
+        {
+            Erreur() << "Uniquement en mode non-stop\n";
+            return;
+        }
+        if (m_ProcInfo -> STATUS == ProcInfo::STAT_TERMINATED)
+        {
+            Erreur() << PROCENDED;
+            return;
+        }
+        if (m_ProcInfo -> STATUS == ProcInfo::STAT_TRACEEND)
+        {
+            Erreur() << "Processus déjà arrêté\n";
+            return;
+        }
+        Tracer (m_Proc);
+        if (m_Suivi == m_Proc) m_Suivi = ProcInfo::invalidProcPid;
+        m_Msg << "Interruption du processus " << m_Proc + 1
+              << " à la ligne "
+              << m_ProcInfo -> procData[m_Proc] -> nextLineNumber -1 << '\n';
+        Arret ("interrupt");
+
+    } // GererInterrupt()
+
     void MiniDbg::GererStatus () throw ()
     {
         if (1 != m_Cmd.size())
         {
-            cout << "Usage : status\n";
+            Erreur() << "Usage : status\n";
             return;
         }
 
@@ -513,108 +1595,189 @@ namespace ProcDebug
         switch (m_ProcInfo -> procData[m_Proc] -> procStatus)
         {
           case ProcInfo::STAT_WAITING :
-            cout << "STAT_WAITING\n";
+            m_Msg << "STAT_WAITING\n";
             break;
           case ProcInfo::STAT_RUNNING :
-            cout << "STAT_RUNNING\n";
+            m_Msg << "STAT_RUNNING\n";
             break;
           case ProcInfo::STAT_IOWAIT :
-            cout << "STAT_IOWAIT\n";
+            m_Msg << "STAT_IOWAIT\n";
             break;
           case ProcInfo::STAT_MUTEXWAIT :
-            cout << "STAT_MUTEXWAIT\n";
+            m_Msg << "STAT_MUTEXWAIT\n";
             break;
           case ProcInfo::STAT_MUTEXGRAB :
-            cout << "STAT_MUTEXGRAB\n";
+            m_Msg << "STAT_MUTEXGRAB\n";
             break;
           case ProcInfo::STAT_NOMUTEX :
-            cout << "STAT_NOMUTEX\n";
+            m_Msg << "STAT_NOMUTEX\n";
             break;
           case ProcInfo::STAT_SYS :
-            cout << "STAT_SYS\n";
+            m_Msg << "STAT_SYS\n";
             break;
           case ProcInfo::STAT_TERMINATED :
-            cout << "STAT_TERMINATED\n";
+            m_Msg << "STAT_TERMINATED\n";
             break;
           case ProcInfo::STAT_TRACEEND :
-            cout << "STAT_TRACEEND\n";
+            m_Msg << "STAT_TRACEEND\n";
             break;
           case ProcInfo::STAT_TRACESTEPRUN :
-            cout << "STAT_TRACESTEPRUN\n";
+            m_Msg << "STAT_TRACESTEPRUN\n";
             break;
           default :
-            cout << "Oops\n";
+            m_Msg << "Oops\n";
         }
 
     } // GererStatus()
 
-    int MiniDbg::GererQuit () throw ()
+    void MiniDbg::GererQuit () throw ()
     {
         if (1 != m_Cmd.size())
         {
-            cout << "Usage : quit\n";
-            return -1;
+            Erreur() << "Usage : quit\n";
+            return;
         }
 
         // On termine proprement les processus avant de sortir
         for (unsigned i(0); m_ProcInfo -> outstandingProcCount; ++i)
-            if (m_ProcInfo -> procData[i] -> procStatus !=
+            if (m_ProcInfo -> procData[i] &&
+                m_ProcInfo -> procData[i] -> procStatus !=
                                             ProcInfo::STAT_TERMINATED)
                 m_ProcInfo -> updateProcData (i, ProcInfo::PROC_TERM);
         // (nb : si le processus n'a pas été tracé
         // (avec SIGQUIT ou changeproc),
         // on n'affichera pas qu'il est terminé);
 
-        m_GoOut = true;
-
-        return 0; // tout c'est bien passé
+        m_GoOut = true; // tout c'est bien passé
 
     } // GererQuit()
 
-    int MiniDbg::GererEnd () throw ()
+    void MiniDbg::GererEnd () throw ()
     {
         if (1 != m_Cmd.size())
         {
-            cout << "Usage : end\n";
-            return -1;
+            Erreur() << "Usage : end\n";
+            return;
         }
 
         // on "détrace" tous les processus avant de sortir
         for (unsigned i(0); i < m_ProcInfo -> procData.size(); ++i)
-            if (m_ProcInfo -> procData[i] -> procStatus !=
+            if (m_ProcInfo -> procData[i] &&
+                m_ProcInfo -> procData[i] -> procStatus !=
                                                 ProcInfo::STAT_TERMINATED)
-                m_ProcInfo -> updateProcData(i, ProcInfo::END_TRACE);
+                Detracer (i);
+        m_Suivi = ProcInfo::invalidProcPid; // plus de breakpoints
 
         m_GoOut = true;
 
-        return 0;
-
     } // GererEnd()
 
-    int MiniDbg::AfficherVar (const std::string & Var) throw ()
+    // Les mots de la commande à partir de Debut, l'expression à compiler
+
+    string MiniDbg::TexteExpr (unsigned Debut) throw ()
     {
-        // l'indice du symbole contenant Var dans symbolTable
-        int Indice (m_ProcInfo -> procData[m_Proc]
-                        -> findExistentSymbol(Var));
+        string Texte;
+        for (unsigned i(Debut); i < m_Cmd.size(); ++i)
+            Texte += (i > Debut ? " " : "") + m_Cmd[i];
+        return Texte;
 
-        if (-1 == Indice)
+    } // TexteExpr()
+
+    // Et ce qu'on en affiche : les blancs ne comptent pas dans le
+    // minilangage, et le mode machine veut un nom d'un seul mot
+
+    string MiniDbg::NomExpr (const string & Texte) throw ()
+    {
+        string Nom;
+        for (unsigned i(0); i < Texte.size(); ++i)
+            if (! isspace (Texte[i])) Nom += Texte[i];
+        return Nom;
+
+    } // NomExpr()
+
+    int MiniDbg::AfficherExpr (const std::string & Texte) throw ()
+    {
+        ProcInfo::CompiledExpr Expr;
+        string ErrMsg;
+        if (! m_ProcInfo -> compileExpr (m_Proc, Texte, &Expr, &ErrMsg))
+        {
+            Erreur() << ErrMsg << '\n';
+            return -1;
+        }
+        int Valeur;
+        if (! m_ProcInfo -> evalExpr (m_Proc, Expr, &Valeur))
         {
-            cerr << "Variable introuvable\n";
+            Erreur() << EVALFAILED "\n";
             return -1;
         }
 
-        cout << m_ProcInfo -> procData[m_Proc] -> symbolTable[Indice] . varIdent
-             << " = "
-             << m_ProcInfo -> procData[m_Proc] -> symbolTable[Indice] . value
-             << '\n';
+        if (m_qMachine)
+            m_Sortie << "@value pid=" << m_Proc + 1 << " name="
+                     << NomExpr (Texte) << " value=" << Valeur << '\n';
+        else
+            m_Sortie << NomExpr (Texte) << " = " << Valeur << '\n';
 
         return 0; // on a réussi a afficher
 
-    } // AfficherVar()
+    } // AfficherExpr()
+
+    // Un tampon, écrit d'un coup : pas de recherche par nom ni
+    // d'écriture par expression, même avec beaucoup d'expressions
+
+    void MiniDbg::AfficherDisplay () throw ()
+    {
+        if (m_Display.empty()) return;
+
+        ostringstream Tampon;
+        for (unsigned i(0); i < m_Display.size(); ++i)
+            AfficherUnDisplay (Tampon, m_Display[i]);
+        const string & Texte (Tampon.str());
+        m_Sortie.write (Texte.data(), Texte.size());
+
+    } // AfficherDisplay()
+
+    // Une expression de la liste : une valeur qu'on ne peut pas calculer
+    // n'est pas une erreur de commande, elle le sera peut-être plus tard
+
+    void MiniDbg::AfficherUnDisplay (ostream & Os, const Affichage & Aff)
+        throw ()
+    {
+        int Valeur;
+        const bool qValeur (Aff.m_qResolue &&
+                            m_ProcInfo -> evalExpr (m_Proc, Aff.m_Expr,
+                                                    &Valeur));
+        if (m_qMachine)
+        {
+            if (qValeur)
+                Os << "@value pid=" << m_Proc + 1 << " name="
+                   << Aff.m_Nom << " value=" << Valeur << '\n';
+        }
+        else if (! Aff.m_qResolue)
+            Os << Aff.m_Nom << " : absente de ce programme\n";
+        else if (! qValeur)
+            Os << Aff.m_Nom << " : non calculable\n";
+        else
+            Os << Aff.m_Nom << " = " << Valeur << '\n';
+
+    } // AfficherUnDisplay()
+
+    // Les indices changent avec le programme du processus tracé
+
+    void MiniDbg::ResoudreDisplay () throw ()
+    {
+        string ErrMsg;
+        for (unsigned i(0); i < m_Display.size(); ++i)
+            m_Display[i].m_qResolue = m_ProcInfo -> compileExpr (m_Proc,
+                                          m_Display[i].m_Texte,
+                                          &m_Display[i].m_Expr, &ErrMsg);
+
+    } // ResoudreDisplay()
 
     void MiniDbg::SetProc (int Proc) throw ()
     {
         m_Proc = Proc;
+        ResoudreDisplay(); // une fois par entrée dans le débugger, et
+                           // aussi après un restore
 
     } // SetProc()
 
@@ -0,0 +1,170 @@
+/**
+ *
+ * @File : OutputCapture.cxx
+ *
+ * @Synopsis : sortie des PRINT par processus (voir OutputCapture.h)
+ *
+ **/
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+#include "OutputCapture.h"
+#include "CheckPthread.h"
+#include "nsSysteme.h"
+
+using namespace std;
+using namespace nsSysteme;
+
+namespace ProcDebug {
+
+    const unsigned int OutputCapture::RING_SIZE;
+
+    namespace {
+        // l'ecrivain, quand l'anneau est vide ; le producteur, quand il
+        // est plein (en microsecondes)
+        const unsigned int IDLE_WAIT = 1000;
+        const unsigned int FULL_WAIT = 100;
+    }
+
+    OutputCapture::OutputCapture(const CaptureMode m, const string &p) :
+        mode (m), path (p), ring (RING_SIZE), head (0), tail (0),
+        qStop (false), taggedFd (-1), qFailed (false) {
+        if(mode == CAPTURE_NONE) return; // rien a ecrire, pas de thread
+        // ici, pour que l'erreur arrive avant la simulation
+        if(mode == CAPTURE_TAGGED) {
+            taggedFd = Open(path . c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+                            0644);
+        }
+        checkPthread(pthread_create(&thread, 0, writerMain, this),
+                     "pthread_create()");
+    }
+
+    OutputCapture::~OutputCapture() {
+        if(mode == CAPTURE_NONE) return;
+        __sync_synchronize(); // le dernier head avant qStop
+        qStop = true;
+        pthread_join(thread, 0);
+    }
+
+    void OutputCapture::put(const int procPid, string *pText) {
+        if(mode == CAPTURE_NONE || pText -> empty()) {
+            pText -> clear();
+            return;
+        }
+        const unsigned long h (head);
+        while(h - tail == RING_SIZE) ::usleep(FULL_WAIT); // plein
+        Slot & slot (ring[h & (RING_SIZE - 1)]);
+        slot . procPid = procPid;
+        slot . text . swap(*pText);
+        pText -> clear(); // l'ancien texte de la case, deja ecrit
+        __sync_synchronize(); // la case avant head
+        head = h + 1;
+    }
+
+    void * OutputCapture::writerMain(void *arg) {
+        // les signaux sont pour le thread principal
+        sigset_t allSig;
+        sigfillset(&allSig);
+        pthread_sigmask(SIG_BLOCK, &allSig, 0);
+        static_cast<OutputCapture *>(arg) -> writerLoop();
+        return 0;
+    }
+
+    void OutputCapture::writerLoop() {
+        for(;;) {
+            const bool qLast (qStop); // lu avant head : rien ne manquera
+            __sync_synchronize();
+            const unsigned long h (head);
+            __sync_synchronize(); // les cases apres head
+            if(tail == h) {
+                if(qLast) break;
+                ::usleep(IDLE_WAIT);
+                continue;
+            }
+            for(unsigned long t (tail); t != h; ++t) {
+                consume(&ring[t & (RING_SIZE - 1)]);
+            }
+            __sync_synchronize(); // les cases lues avant de les rendre
+            tail = h;
+        }
+        finish();
+    }
+
+    void OutputCapture::consume(Slot *pSlot) {
+        if(qFailed) return;
+        try {
+            if(mode == CAPTURE_FILES) {
+                map<int, int>::iterator iFd (fds . find(pSlot -> procPid));
+                if(iFd == fds . end()) {
+                    ostringstream fileName;
+                    fileName << path << '.' << pSlot -> procPid + 1;
+                    iFd = fds . insert(make_pair(pSlot -> procPid,
+                              Open(fileName . str() . c_str(),
+                                   O_WRONLY | O_CREAT | O_TRUNC, 0644)))
+                              . first;
+                }
+                writeAll(iFd -> second, pSlot -> text);
+                return;
+            }
+            // CAPTURE_TAGGED : les lignes completes, chacune avec son pid
+            string & line (pending[pSlot -> procPid]);
+            string out;
+            for(string::size_type begin (0), end; begin <
+                    pSlot -> text . size(); begin = end + 1) {
+                end = pSlot -> text . find('\n', begin);
+                if(end == string::npos) {
+                    line . append(pSlot -> text, begin, string::npos);
+                    break;
+                }
+                ostringstream tag;
+                tag << '[' << pSlot -> procPid + 1 << "] ";
+                out += tag . str();
+                out += line;
+                out . append(pSlot -> text, begin, end + 1 - begin);
+                line . clear();
+            }
+            writeAll(taggedFd, out);
+        }
+        catch (const CExc & Exc) {
+            cerr << Exc << "CAPTURE output discarded from now on\n";
+            qFailed = true;
+        }
+    }
+
+    void OutputCapture::writeAll(const int fd, const string &str) {
+        for(string::size_type done = 0; done < str . size(); ) {
+            done += Write(fd, str . data() + done, str . size() - done);
+        }
+    }
+
+    // a la fin : les lignes restees commencees, terminees par '\n'
+
+    void OutputCapture::finish() {
+        try {
+            for(map<int, string>::iterator i (pending . begin());
+                !qFailed && i != pending . end(); ++i) {
+                if(i -> second . empty()) continue;
+                ostringstream tag;
+                tag << '[' << i -> first + 1 << "] " << i -> second << '\n';
+                writeAll(taggedFd, tag . str());
+            }
+            if(taggedFd >= 0) Close(taggedFd);
+            for(map<int, int>::iterator i (fds . begin());
+                i != fds . end(); ++i) {
+                Close(i -> second);
+            }
+        }
+        catch (const CExc & Exc) {
+            cerr << Exc << endl;
+        }
+    }
+
+} // namespace ProcDebug
@@ -0,0 +1,180 @@
+/**
+ *
+ * @File : ParEngine.cxx
+ *
+ * @Synopsis : moteur parallele (voir ParEngine.h)
+ *
+ **/
+
+#include <vector>
+#include <deque>
+#include <cerrno>
+#include <signal.h>
+#include <pthread.h>
+
+#include "ParEngine.h"
+#include "CheckPthread.h"
+#include "nsSysteme.h"
+
+using namespace std;
+using namespace nsSysteme;
+
+namespace ProcDebug {
+
+    void checkPthread(const int res, const char *fctName) {
+        if(res) {
+            errno = res;
+            throw CExc(fctName, "");
+        }
+    }
+
+    const int ParEngine::DEFAULT_QUANTUM;
+
+    ParEngine::ParEngine(ProcInfo *pI, const int nbThreads,
+                         const int quant) :
+        pInfo (pI), quantum (quant < 1 ? 1 : quant),
+        tickGeneration (0), busyWorkers (0), qStop (false) {
+        checkPthread(pthread_mutex_init(&tickLock, 0),  "pthread_mutex_init()");
+        checkPthread(pthread_cond_init (&tickStart, 0), "pthread_cond_init()");
+        checkPthread(pthread_cond_init (&tickEnd, 0),   "pthread_cond_init()");
+        pInfo -> qParallel = true;
+        for(int kThread = 0; kThread < nbThreads; ++kThread) {
+            Worker * w (new Worker);
+            w -> engine = this;
+            checkPthread(pthread_mutex_init(&w -> lock, 0),
+                         "pthread_mutex_init()");
+            workers . push_back(w);
+            checkPthread(pthread_create(&w -> thread, 0, workerMain, w),
+                         "pthread_create()");
+        }
+    }
+
+    ParEngine::~ParEngine() {
+        pthread_mutex_lock(&tickLock);
+        qStop = true;
+        pthread_cond_broadcast(&tickStart);
+        pthread_mutex_unlock(&tickLock);
+        for(unsigned int kThread = 0; kThread < workers . size(); ++kThread) {
+            pthread_join(workers[kThread] -> thread, 0);
+            pthread_mutex_destroy(&workers[kThread] -> lock);
+            delete workers[kThread];
+        }
+        pthread_cond_destroy (&tickEnd);
+        pthread_cond_destroy (&tickStart);
+        pthread_mutex_destroy(&tickLock);
+        pInfo -> qParallel = false;
+    }
+
+    void * ParEngine::workerMain(void *arg) {
+        // les signaux (SIGQUIT pour le debugger, ceux du SIGNAL du
+        // minilangage) sont pour le thread principal uniquement
+        sigset_t allSig;
+        sigfillset(&allSig);
+        pthread_sigmask(SIG_BLOCK, &allSig, 0);
+        Worker * self (static_cast<Worker *>(arg));
+        self -> engine -> workerLoop(self);
+        return 0;
+    }
+
+    // sa propre file par devant, sinon celle des autres par derriere
+
+    bool ParEngine::popTask(Worker *self, int *taskIndex) {
+        pthread_mutex_lock(&self -> lock);
+        if(self -> tasks . size()) {
+            *taskIndex = self -> tasks . front();
+            self -> tasks . pop_front();
+            pthread_mutex_unlock(&self -> lock);
+            return true;
+        }
+        pthread_mutex_unlock(&self -> lock);
+        for(unsigned int kThread = 0; kThread < workers . size(); ++kThread) {
+            Worker * victim (workers[kThread]);
+            if(victim == self) continue;
+            pthread_mutex_lock(&victim -> lock);
+            if(victim -> tasks . size()) {
+                *taskIndex = victim -> tasks . back();
+                victim -> tasks . pop_back();
+                pthread_mutex_unlock(&victim -> lock);
+                return true;
+            }
+            pthread_mutex_unlock(&victim -> lock);
+        }
+        return false;
+    }
+
+    void ParEngine::workerLoop(Worker *self) {
+        for(unsigned long seenGeneration (0); ; ) {
+            pthread_mutex_lock(&tickLock);
+            while(!qStop && tickGeneration == seenGeneration) {
+                pthread_cond_wait(&tickStart, &tickLock);
+            }
+            if(qStop) {
+                pthread_mutex_unlock(&tickLock);
+                return;
+            }
+            seenGeneration = tickGeneration;
+            pthread_mutex_unlock(&tickLock);
+
+            for(int kTask; popTask(self, &kTask); ) {
+                Task & task (taskList[kTask]);
+                task . steps = pInfo -> runQuantum(task . procPid, quantum,
+                                                   &task . qSerial);
+            }
+
+            pthread_mutex_lock(&tickLock);
+            if(--busyWorkers == 0) {
+                pthread_cond_signal(&tickEnd);
+            }
+            pthread_mutex_unlock(&tickLock);
+        }
+    } // workerLoop()
+
+    void ParEngine::runTick(const vector<int> &electedProcs) {
+        taskList . clear();
+        for(unsigned int kProc = 0; kProc < electedProcs . size(); ++kProc) {
+            const int procPid (electedProcs[kProc]);
+            ProcInfo::ProcStatus & status (
+                pInfo -> procData[procPid] -> procStatus);
+            if(status == ProcInfo::STAT_RUNNING) {
+                continue; // deja elu a ce tick (doublon dans une file)
+            }
+            if(status != ProcInfo::STAT_WAITING) {
+                // trace par le debugger, termine... : le chemin habituel
+                pInfo -> avancerDUnPas(procPid);
+                continue;
+            }
+            status = ProcInfo::STAT_RUNNING;
+            taskList . push_back(Task(procPid));
+        }
+        if(taskList . empty()) return;
+        for(unsigned int kTask = 0; kTask < taskList . size(); ++kTask) {
+            workers[kTask % workers . size()] -> tasks . push_back(kTask);
+        }
+
+        // pas de debugger (SIGQUIT) pendant que les threads travaillent
+        sigset_t sigQuit, oldMask;
+        Sigemptyset(&sigQuit);
+        Sigaddset  (&sigQuit, SIGQUIT);
+        Sigprocmask(SIG_BLOCK, &sigQuit, &oldMask);
+
+        pthread_mutex_lock(&tickLock);
+        busyWorkers = workers . size();
+        ++tickGeneration;
+        pthread_cond_broadcast(&tickStart);
+        while(busyWorkers) {
+            pthread_cond_wait(&tickEnd, &tickLock);
+        }
+        pthread_mutex_unlock(&tickLock);
+
+        Sigprocmask(SIG_SETMASK, &oldMask, 0);
+
+        // dans l'ordre d'election, pour que les FORK et les PRINT en
+        // attente se fassent toujours dans le meme ordre
+        for(unsigned int kTask = 0; kTask < taskList . size(); ++kTask) {
+            pInfo -> finishQuantum(taskList[kTask] . procPid,
+                                   taskList[kTask] . steps,
+                                   taskList[kTask] . qSerial);
+        }
+    } // runTick()
+
+} // namespace ProcDebug
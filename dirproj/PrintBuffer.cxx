@@ -0,0 +1,106 @@
+/**
+ *
+ * @File : PrintBuffer.cxx
+ *
+ * @Synopsis : tampon de la sortie des PRINT (voir PrintBuffer.h)
+ *
+ **/
+
+#include <iostream>
+#include <string>
+#include <string.h>
+#include <unistd.h>
+
+#include "PrintBuffer.h"
+#include "nsSysteme.h"
+
+using namespace std;
+using namespace nsSysteme;
+
+namespace ProcDebug {
+
+    const unsigned int PrintBuffer::BUF_SIZE;
+    const unsigned int PrintBuffer::INT_DIGITS;
+
+    PrintBuffer::PrintBuffer(const int f) :
+        fd (f), policy (::isatty(f) ? FLUSH_LINE : FLUSH_FULL),
+        bufLength (0), qNewLine (false), qInPrint (0) {}
+
+    PrintBuffer::~PrintBuffer() {
+        try {
+            flush();
+        }
+        catch (const CExc & Exc) {
+            cerr << Exc << endl;
+        }
+    }
+
+    // sans passer par un ostringstream : c'est l'essentiel des PRINT
+
+    char * PrintBuffer::formatInt(const int value, char *end) {
+        char *p (end);
+        unsigned int v (value < 0 ? -static_cast<unsigned int>(value)
+                                  : static_cast<unsigned int>(value));
+        do {
+            *--p = static_cast<char>('0' + v % 10);
+        } while(v /= 10);
+        if(value < 0) *--p = '-';
+        return p;
+    }
+
+    char * PrintBuffer::appendInt(const int value, char *p) {
+        char digits[INT_DIGITS];
+        const char *begin (formatInt(value, digits + INT_DIGITS));
+        const unsigned int length (digits + INT_DIGITS - begin);
+        memcpy(p, begin, length);
+        return p + length;
+    }
+
+    void PrintBuffer::put(const int value) {
+        char digits[INT_DIGITS];
+        const char *p (formatInt(value, digits + INT_DIGITS));
+        put(p, digits + INT_DIGITS - p);
+    }
+
+    void PrintBuffer::put(const char *str, const unsigned int length) {
+        if(!qNewLine && memchr(str, '\n', length)) qNewLine = true;
+        if(bufLength + length > BUF_SIZE) {
+            write();
+            if(length > BUF_SIZE) { // ne tiendrait pas : directement
+                for(unsigned int done = 0; done < length; ) {
+                    done += Write(fd, str + done, length - done);
+                }
+                return;
+            }
+        }
+        memcpy(buf + bufLength, str, length);
+        bufLength += length;
+    }
+
+    char * PrintBuffer::reserve(const unsigned int length) {
+        if(length > BUF_SIZE) return 0;
+        if(bufLength + length > BUF_SIZE) write();
+        return buf + bufLength;
+    }
+
+    void PrintBuffer::endPrint() {
+        qInPrint = 0;
+        if(policy == FLUSH_ALWAYS || (policy == FLUSH_LINE && qNewLine)) {
+            write();
+        }
+    }
+
+    void PrintBuffer::flush() {
+        if(qInPrint) return; // SIGQUIT au milieu d'un PRINT
+        write();
+    }
+
+    void PrintBuffer::write() {
+        cout . flush(); // ce qui a ete ecrit avant sort avant
+        for(unsigned int done = 0; done < bufLength; ) {
+            done += Write(fd, buf + done, bufLength - done);
+        }
+        bufLength = 0;
+    }
+
+} // namespace ProcDebug
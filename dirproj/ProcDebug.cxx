@@ -17,6 +17,8 @@
 #include <string>
 #include <vector>
 #include <deque> 
+#include <algorithm>
+#include <cctype>
 #include <sstream>
 #include <signal.h>
 #include <sys/types.h>
@@ -24,8 +26,12 @@
 #include <unistd.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "ProcDebug.h"
+#include "Journal.h"
+#include "OutputCapture.h"
+#include "InputFeed.h"
 #include "nsSysteme.h"
 
 using namespace std;
@@ -62,7 +68,8 @@ namespace ProcDebug {
         // On avance d'une instruction
         updateProcData (procPid, ADVANCE_PROC, prog);
 
-        if (STATUS != STAT_TERMINATED)
+        // (un READ en attente d'une ligne reste en STAT_IOWAIT)
+        if (STATUS != STAT_TERMINATED && STATUS != STAT_IOWAIT)
             STATUS = (STATUS == STAT_TRACESTEPRUN) ? STAT_TRACEEND
                                                    : STAT_WAITING;
 
@@ -74,6 +81,83 @@ namespace ProcDebug {
 
     } // avancerDUnPas()
 
+    // la boucle de avancerDUnPas(), sans revenir au debugger entre deux
+    // pas, et avec le masque de SIGQUIT pose une fois pour toutes (ou
+    // presque)
+
+    ProcInfo::StepStop ProcInfo::stepTraced(
+        const int procPid, const StepMode mode, const unsigned long arg,
+        const vector<bool> *pStopLines, const vector<CompiledCond> *pStopConds,
+        unsigned long *pSteps) {
+        ProcData *pData (procData[procPid]);
+        *pSteps = 0;
+        if(pData -> procStatus == STAT_TERMINATED) return STOP_EXIT;
+
+        // le WHILE dont il faut sortir, pour next et finish
+        const ProcInstruction *crt  (findCrtInstruction(pData -> proGram));
+        const ProcInstruction *loop (0);
+        if(mode == STEP_FINISH) {
+            for(loop = crt -> father; loop &&
+                loop -> instructionType != DO_WHILEREPEAT;
+                loop = loop -> father);
+            if(!loop) return STOP_NOLOOP;
+        }
+        else if(mode == STEP_OVER &&
+                crt -> instructionType == DO_WHILEREPEAT) {
+            loop = crt;
+        }
+
+        const ProcStatus tracedStatus (pData -> procStatus);
+        StepStop why (STOP_DONE);
+        Sigprocmask(SIG_BLOCK, &pData -> sigMask, 0);
+        for(;;) {
+            pData -> procStatus = (tracedStatus == STAT_TRACEEND) ?
+                STAT_TRACESTEPRUN : STAT_RUNNING;
+            updateProcData(procPid, ADVANCE_PROC, pData -> proGram);
+            ++*pSteps;
+            if(pData -> procStatus == STAT_TERMINATED) {
+                why = STOP_EXIT;
+                break;
+            }
+            pData -> procStatus = tracedStatus;
+            if(watchHit . procPid != invalidProcPid) {
+                why = STOP_WATCH;
+                break;
+            }
+            crt = findCrtInstruction(pData -> proGram);
+            const unsigned int line (crt -> lineNumber);
+            bool qCondFailed;
+            if(pStopLines && line < pStopLines -> size() &&
+               (*pStopLines)[line] &&
+               evalCond(procPid, (*pStopConds)[line], &qCondFailed)) {
+                why = qCondFailed ? STOP_CONDERROR : STOP_BREAK;
+                break;
+            }
+            if(mode == STEP_COUNT) {
+                if(*pSteps >= arg) break;
+            }
+            else if(mode == STEP_UNTIL) {
+                if(line == arg) break;
+            }
+            else {
+                if(!loop) break; // next sur une instruction simple
+                const ProcInstruction *p (crt);
+                while(p && p != loop) p = p -> father;
+                if(!p) break;    // sorti du WHILE
+            }
+            if(*pSteps % STEP_SIGNAL_PERIOD == 0) {
+                Sigprocmask(SIG_UNBLOCK, &pData -> sigMask, 0);
+                Sigprocmask(SIG_BLOCK,   &pData -> sigMask, 0);
+                if(pData -> procStatus != tracedStatus) {
+                    why = STOP_INTERRUPT;
+                    break;
+                }
+            }
+        }
+        Sigprocmask(SIG_UNBLOCK, &pData -> sigMask, 0);
+        return why;
+    } // stepTraced()
+
     // la fonction principale pour l'avancement instruction par instruction,
     // que vous devez ameliorer (eventuellement en rajoutant d'autres
     // fonctions egalement) pour realiser le debugger pas-a-pas avec inspection
@@ -93,7 +177,8 @@ namespace ProcDebug {
         }
         switch(p) {
             case PROC_TERM: {
-                doTerminateProc(procPid);      
+                doTerminateProc(procPid, EXIT_KILLED);
+                flushProgress(procPid);
                 return 0;
             }
             case START_TRACE: {
@@ -114,12 +199,23 @@ namespace ProcDebug {
                     displayProcInfo(&cerr, procPid);
                 }
                 if(procData[procPid] -> procStatus != STAT_TRACEEND) {
-                    doOneStepAndAdvancePC(procPid, prog);
-                    if(procData[procPid] -> procStatus != STAT_TERMINATED) {
+                    // un pas du debugger (STAT_TRACESTEPRUN) n'a pas sorti
+                    // le processus de sa file : pas de doublon
+                    const bool qElected (procData[procPid] -> procStatus !=
+                                         STAT_TRACESTEPRUN);
+                    doOneLoggedStep(procPid, prog);
+                    scheduler -> noteStep();
+                    flushProgress(procPid);
+                    if(qElected && 
+                       procData[procPid] -> procStatus != STAT_TERMINATED &&
+                       procData[procPid] -> procStatus != STAT_IOWAIT) {
                         scheduler -> enQueueProc(procPid);
                     }
                     return 0;
                 }
+                // un processus arrete par le debugger : c'est l'utilisateur
+                // qui a la main, on ne parle donc pas d'interblocage
+                scheduler -> noteProgress();
                 scheduler -> enQueueProc(procPid);
                 return 0;
             }
@@ -259,6 +355,176 @@ namespace ProcDebug {
     } // displayProcInfo()
 
 
+    // le moteur parallele (voir ParEngine.cxx) : un thread de travail
+    // avance un processus de plusieurs pas d'affilee ; les entrees/sorties
+    // et le FORK (qui agrandit procData et touche a l'ordonnanceur) sont
+    // laisses au thread principal, pour qu'ils restent dans l'ordre
+    // et qu'aucun thread de travail n'ait besoin de verrou
+
+    bool ProcInfo::qIsSerialInstruction(const ProcInstructionType t) {
+        return t == DO_READ || t == DO_PRINT || t == DO_FORK ||
+               t == DO_DEVREAD || t == DO_DEVWRITE;
+    }
+
+    int ProcInfo::runQuantum(const int procPid, const int maxSteps,
+                             bool *pQSerial) {
+        ProcData * pData (procData[procPid]);
+        int steps (0);
+        *pQSerial = false;
+        for(; steps < maxSteps; ++steps) {
+            const ProcInstruction * p (findCrtInstruction(pData -> proGram));
+            if(p && qIsSerialInstruction(p -> instructionType)) {
+                *pQSerial = true;
+                break;
+            }
+            doOneLoggedStep(procPid, pData -> proGram);
+            if(pData -> procStatus      == STAT_TERMINATED ||
+               pData -> procMutexStatus == STAT_MUTEXWAIT) {
+                // inutile d'insister sur un P, il faut laisser
+                // tourner les autres
+                ++steps;
+                break;
+            }
+        }
+        return steps;
+    } // runQuantum()
+
+    void ProcInfo::finishQuantum(const int procPid, const int steps,
+                                 const bool qSerial) {
+        scheduler -> noteSteps(steps);
+        flushProgress(procPid);
+        if(STATUS == STAT_TERMINATED) return;
+        STATUS = STAT_WAITING;
+        if(qSerial) {
+            avancerDUnPas(procPid); // l'instruction en attente, ici-meme,
+            // et c'est updateProcData() qui le remet en file
+        }
+        else {
+            scheduler -> enQueueProc(procPid);
+        }
+    } // finishQuantum()
+
+    // la table des processus ne grandit que s'il n'y a plus de pid libre :
+    // sa taille est bornee par le nombre maximal de processus vivants
+
+    int ProcInfo::allocPid() {
+        if(freePids . size()) {
+            const int procPid (freePids . back());
+            freePids . pop_back();
+            return procPid;
+        }
+        procData . push_back(0);
+        return procData . size() - 1;
+    }
+
+    void ProcInfo::reapZombies(const int keptPid1, const int keptPid2) {
+        if(zombiePids . empty()) return;
+        // le debugger (SIGQUIT) ne doit pas voir la table a moitie videe
+        sigset_t sigQuit, oldMask;
+        Sigemptyset(&sigQuit);
+        Sigaddset  (&sigQuit, SIGQUIT);
+        Sigprocmask(SIG_BLOCK, &sigQuit, &oldMask);
+        procExit . resize(procData . size());
+        unsigned int nbKept (0);
+        for(unsigned int k = 0; k < zombiePids . size(); ++k) {
+            const int procPid (zombiePids[k]);
+            if(procPid == keptPid1 || procPid == keptPid2 ||
+               procPid == mutexOwner         || // pour le graphe d'attente
+               procData[procPid] -> symbolWatch . cells . size() ||
+               procData[procPid] -> heapWatch   . cells . size()) {
+                zombiePids[nbKept++] = procPid;
+                continue;
+            }
+            ++procExit[procPid] . generation;
+            procExit[procPid] . exitCode = procData[procPid] -> exitCode;
+            delete procData[procPid];
+            procData[procPid] = 0;
+            scheduler -> forgetProc(procPid);
+            freePids . push_back(procPid);
+            ++reapedCount;
+        }
+        zombiePids . resize(nbKept);
+        Sigprocmask(SIG_SETMASK, &oldMask, 0);
+    } // reapZombies()
+
+    const unsigned int ProcInfo::INPUT_POLL_TICKS;
+    const int          ProcInfo::DBG_INPUT_WAIT;
+
+    void ProcInfo::pollInput(const bool qIdle) {
+        if(!qIdle && scheduler -> getTick() % INPUT_POLL_TICKS) return;
+        stdinLines . poll(qIdle ? inputIdleWait : 0);
+        // a la fin de l'entree, tous : leur READ les terminera
+        for(unsigned int nbLines (stdinLines . lineCount());
+            ioWaitPids . size() && (nbLines || stdinLines . qAtEnd()); ) {
+            const int procPid (ioWaitPids . front());
+            ioWaitPids . pop_front();
+            if(procData[procPid] == 0 ||
+               procData[procPid] -> procStatus != STAT_IOWAIT) continue;
+            procData[procPid] -> procStatus = STAT_WAITING;
+            scheduler -> enQueueProc(procPid);
+            scheduler -> noteProgress();
+            if(nbLines) --nbLines;
+        }
+    } // pollInput()
+
+    void ProcInfo::completeDeviceIo() {
+        for(int procPid; device . takeDone(scheduler -> getTick(),
+                                           &procPid); ) {
+            ProcData * pData (procData[procPid]);
+            if(pData == 0 || pData -> devState != DEV_PENDING) continue;
+            pData -> devState = DEV_DONE;
+            if(pData -> procStatus != STAT_IOWAIT) continue; // trace
+            pData -> procStatus = STAT_WAITING;
+            scheduler -> enQueueProc(procPid);
+            scheduler -> noteProgress();
+        }
+    } // completeDeviceIo()
+
+    bool ProcInfo::qInputWait() const {
+        for(unsigned int k = 0; k < ioWaitPids . size(); ++k) {
+            if(procData[ioWaitPids[k]] &&
+               procData[ioWaitPids[k]] -> procStatus == STAT_IOWAIT) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool ProcInfo::qReadsStdin(const int procPid) const {
+        const ProcData * pData (procData[procPid]);
+        const InputFeed * feed (input ? input -> find(pData -> progName)
+                                      : 0);
+        if(feed && feed -> qEndless()) return false;
+        return qHasInstruction(pData -> proGram, DO_READ) ||
+               qHasInstruction(pData -> hanDler, DO_READ);
+    }
+
+    // statistiques de fin de simulation (option --stats de proj.run)
+
+    void ProcInfo::dumpProcInfoStat(ostream *s) const {
+        (*s) << "Stat: " << procData . size() << " pid(s), "
+             << outstandingProcCount << " still running, "
+             << reapedCount << " reaped\n";
+        for(unsigned int kProc = 0; kProc < procData . size(); ++kProc) {
+            if(procData[kProc]) {
+                (*s) << "  [" << kProc + 1 << "] " << procData[kProc] -> progName
+                     << " " << procStateStr[procData[kProc] -> procStatus]
+                     << "\n";
+            }
+            else if(kProc < procExit . size() &&
+                    procExit[kProc] . generation) {
+                // pid libre : ce qu'on sait du dernier fils qui l'a occupe
+                (*s) << "  [" << kProc + 1 << "] free, "
+                     << procExit[kProc] . generation << " reaped, last exit "
+                     << exitCodeStr[procExit[kProc] . exitCode] << "\n";
+            }
+        }
+        if(scheduler) {
+            scheduler -> dumpStat(s);
+            device . dumpStat(s, scheduler -> getTick());
+        }
+    } // dumpProcInfoStat()
+
     //////////////////////////////////////////////////////////////////////
     // avec ces trois fonctions et les structures de donnees declarees   //
     // dans ProcDebug.h, dont notamment symbolTable, vous avez tous     // 
@@ -295,6 +561,8 @@ namespace ProcDebug {
     // pour ceux qui auront tout fini et voudront ameliorer des choses...
 
     const int    ProcInfo::ONE_INSTRUCTION_SLEEP;
+    const unsigned int ProcInfo::DEFAULT_UNDO_LOG_SIZE;
+    const unsigned long ProcInfo::STEP_SIGNAL_PERIOD;
     const int    ProcInfo::THE_SHARED_MEMORY;
     const int    ProcInfo::THE_MUTEX;
     const int    ProcInfo::MUTEX_OPER_P;
@@ -304,6 +572,7 @@ namespace ProcDebug {
                                              "mutexwait","mutexgrab","nomutex",
                                              "sys","term",
                                              "tracestop","tracerun"};
+    const char * ProcInfo::exitCodeStr[]  = {"normal","error","killed"};
     const char  * ProcInfo::operChar[]    = {" ","@",",",":",
                                              "(",")","\"","\"",
                                              "$",
@@ -330,7 +599,8 @@ namespace ProcDebug {
                                                     "READ","PRINT","FORK",
                                                     "MUTEX","WHILE","PROGRAM",
                                                     "NOTHING", "SIGNAL",
-                                                    "SIGADD", "SIGDEL"};
+                                                    "SIGADD", "SIGDEL",
+                                                    "DEVREAD", "DEVWRITE"};
     
     ProcInfo::ProcInstruction::ProcInstruction(const ProcInstruction& instr) {
         // le constructor par recopie -- tres important pour le FORK
@@ -350,6 +620,43 @@ namespace ProcDebug {
         father          = 0; //sera normlmnt initialise par celui qui appelle
         lineNumber      = instr . lineNumber;
         fileName        = instr . fileName;
+        printText       = instr . printText;
+        printHoles      = instr . printHoles;
+        qPrintNewLine   = instr . qPrintNewLine;
+    }
+
+    // l'affectation (pour "start", qui remet proGram a proGramInit) doit
+    // etre profonde elle aussi, sinon les deux arbres partageraient leurs
+    // noeuds ; le pere, lui, reste celui de l'instruction affectee
+
+    ProcInfo::ProcInstruction &
+    ProcInfo::ProcInstruction::operator = (const ProcInstruction& instr) {
+        if(this == &instr) return *this;
+        ProcInstruction * const savedFather (father);
+        ProcInstruction copy (instr);
+        bodyInstr . swap(copy . bodyInstr); // copy libere les anciens
+        for(unsigned int k = 0; k < bodyInstr . size(); ++k) {
+            bodyInstr[k] -> father = this;
+        }
+        instructionType = instr . instructionType;
+        operType        = instr . operType;
+        operand         = instr . operand;
+        leftValue       = instr . leftValue;
+        condEval        = instr . condEval;
+        programCounter  = instr . programCounter;
+        father          = savedFather;
+        lineNumber      = instr . lineNumber;
+        fileName        = instr . fileName;
+        printText       = instr . printText;
+        printHoles      = instr . printHoles;
+        qPrintNewLine   = instr . qPrintNewLine;
+        return *this;
+    }
+
+    ProcInfo::ProcInstruction::~ProcInstruction() {
+        for(unsigned int k = 0; k < bodyInstr . size(); ++k) {
+            delete bodyInstr[k];
+        }
     }
     ProcInfo::ProcData::ProcData(const ProcData& pData) {
         // le constructor par recopie -- tres important pour le FORK
@@ -383,6 +690,18 @@ namespace ProcDebug {
         procStatus           = pData . procStatus;
         procMutexStatus      = pData . procMutexStatus;
         nextLineNumber       = pData . nextLineNumber;
+        qProgress            = false;
+        qReapable            = pData . qReapable;
+        exitCode             = pData . exitCode;
+        devState             = DEV_IDLE; // le fils n'attend pas le disque
+        stepCount            = 0;
+        traceLines           = pData . traceLines;
+    }
+
+    ProcInfo::ProcData::~ProcData() {
+        delete proGram;
+        delete hanDler;
+        delete proGramInit;
     }
 
     void 
@@ -516,6 +835,57 @@ namespace ProcDebug {
         }
     }
 
+    // un PRINT ne passe plus ses operandes un a un au tampon : les
+    // chaines et les nombres (dont la valeur ne change pas) sont mis bout
+    // a bout ici, une fois pour toutes, et l'execution n'a plus qu'a
+    // recopier le texte en y inserant la valeur des variables. on
+    // reconnait une constante a son strValue (le texte du nombre pour un
+    // nombre), vide pour une variable
+
+    void ProcInfo::ProcData::compilePrint(ProcInstruction *instr) {
+        char digits[PrintBuffer::INT_DIGITS];
+        char * const end (digits + PrintBuffer::INT_DIGITS);
+        for(unsigned int k = 0; k < instr -> operand . size(); ++k) {
+            const ProcSymbol & symbol (symbolTable[instr -> operand[k]]);
+            if(symbol . opType != OPND_TYPE_INT) {
+                instr -> printText += symbol . strValue;
+            }
+            else if(symbol . strValue . size()) {
+                instr -> printText . append(
+                    PrintBuffer::formatInt(symbol . value, end), end);
+            }
+            else {
+                ProcInstruction::PrintHole hole;
+                hole . textPos = instr -> printText . size();
+                hole . symbol  = instr -> operand[k];
+                instr -> printHoles . push_back(hole);
+            }
+        }
+        instr -> qPrintNewLine =
+            instr -> printText . find('\n') != string::npos;
+    }
+
+    unsigned int ProcInfo::ProcData::printMaxLength(
+        const ProcInstruction *instr) const {
+        return instr -> printText . size() +
+               instr -> printHoles . size() * PrintBuffer::INT_DIGITS;
+    }
+
+    char * ProcInfo::ProcData::fillPrint(const ProcInstruction *instr,
+                                         char *p) const {
+        const char * const text (instr -> printText . data());
+        unsigned int done (0);
+        for(unsigned int k = 0; k < instr -> printHoles . size(); ++k) {
+            const ProcInstruction::PrintHole & hole (instr -> printHoles[k]);
+            memcpy(p, text + done, hole . textPos - done);
+            p += hole . textPos - done;
+            done = hole . textPos;
+            p = PrintBuffer::appendInt(symbolTable[hole . symbol] . value, p);
+        }
+        memcpy(p, text + done, instr -> printText . size() - done);
+        return p + instr -> printText . size() - done;
+    }
+
     // fonction importante pour le parsing : decoupage d'une ligne en
     // lexemes (tokens) (la deque est la pour la facilite d'insertion) et
     // leur categorisation (symbole, nombre, operateur (et lequel), etc.)
@@ -763,6 +1133,8 @@ namespace ProcDebug {
         //    . FORK    @ <Var>     // 0 si fils,pid du fils (int) si pere
         //    . MUTEX   @ _ : P            
         //    . MUTEX   @ _ : V
+        //    . DEVREAD  @ <Var> : <nbrOuVar>  // bloc -> <Var>$0...
+        //    . DEVWRITE @ <Var> : <nbrOuVar>  // <Var>$0... -> bloc
         //
         //   Pour le STORE ou le LOAD on peut utiliser '_' pour designer 
         //     la memoire partagee, par exemple :
@@ -1281,6 +1653,60 @@ namespace ProcDebug {
             }
             return newInstr;
         }// if(COPY)
+        if(fileContent[firstLine][0] . token == "DEVREAD" ||
+           fileContent[firstLine][0] . token == "DEVWRITE") {
+            const string theKeyword(fileContent[firstLine][0] . token);
+            if(fileContent[firstLine] . size() != 5                     ||
+               fileContent[firstLine][2] . tokenType != INSTRTOK_SYMBOL ||
+               fileContent[firstLine][3] . tokenType != INSTRTOK_OPER   ||
+               fileContent[firstLine][3] . tokenOperType != OP_ASSIGN) {
+                cerr << "SYNTAX ERROR Bad '" << theKeyword << "'...\n";
+                delete newInstr;
+                return 0;
+            }
+            newInstr -> instructionType = theKeyword == "DEVREAD" ?
+                                          DO_DEVREAD : DO_DEVWRITE;
+            *newLastLine = firstLine;
+            // la base dans le tas, puis le numero du bloc
+            if((newInstr -> leftValue = findExistentSymbol(
+                fileContent[firstLine][2] . token)) == -1) {
+                cerr << "ALG ERROR in " << theKeyword << " Undefined symbol "
+                     << fileContent[firstLine][2] . token << "\n";
+                delete newInstr;
+                return 0;
+            }
+            switch(fileContent[firstLine][4] . tokenType) {
+                case INSTRTOK_SYMBOL:
+                    newInstr -> operand . push_back(
+                        findExistentSymbol(
+                            fileContent[firstLine][4] . token));
+                    if(newInstr -> operand . back() == -1) {
+                        cerr << "ALG ERROR in " << theKeyword
+                             << " Undefined symbol "
+                             << fileContent[firstLine][4] . token << "\n";
+                        delete newInstr;
+                        return 0;
+                    }
+                    break;
+                case INSTRTOK_NUMBER:
+                    newInstr -> operand . push_back(
+                        addNewSymbol(
+                            fileContent[firstLine][4]));
+                    break;
+                default:
+                    cerr << "SYNTAX ERROR Invalid token "
+                         << fileContent[firstLine][4] . token
+                         << " in " << theKeyword
+                         << ". Only integers or variables.\n";
+                    delete newInstr;
+                    return 0;
+            } // switch(tokenType)
+            if(qParsingVerbose) {
+                cerr << " -> " << instructionKeyword[
+                    newInstr -> instructionType];
+            }
+            return newInstr;
+        }// if(DEVREAD or DEVWRITE)
         if(fileContent[firstLine][0] . token == "PRINT") {
             newInstr -> instructionType = DO_PRINT;
             *newLastLine = firstLine;
@@ -1325,6 +1751,7 @@ namespace ProcDebug {
                     return 0;
                 } // switch(tokenType)
             } // for(each token)
+            compilePrint(newInstr);
             if(qParsingVerbose) {
                 cerr << " -> " << instructionKeyword[
                     newInstr -> instructionType];
@@ -1462,6 +1889,24 @@ namespace ProcDebug {
         sharedMemoryLimit = memoryLimitForAll;
         sharedMemory . resize(sharedMemoryLimit);
         mutex             = 1;
+        mutexOwner        = invalidProcPid;
+        maxProgLength     = 0;
+        scheduler         = 0;
+        reapedCount       = 0;
+        watchCount        = 0;
+        watchHit . procPid = invalidProcPid;
+        traceNext         = 0;
+        traceDumped       = 0;
+        zombieLock        = 0;
+        journal           = 0;
+        capture           = 0;
+        input             = 0;
+        qAsyncRead        = true;
+        inputIdleWait     = -1;
+        qParallel         = false;
+        qMemSnapshot      = false;
+        snapLock          = 0;
+        undoLogSize       = DEFAULT_UNDO_LOG_SIZE;
         istringstream buffStr(fileList);
         for(string fileName; buffStr >> fileName;) { // pour chaque fichier
             ifstream progFile (fileName . c_str());
@@ -1476,7 +1921,9 @@ namespace ProcDebug {
             }
             bool qOk (true);
             ProgToken fileContent; 
+            vector<string> source; // le texte tel quel, pour la table
             for(string fileLine; getline(progFile, fileLine);) {
+                source . push_back(fileLine);
                 stripWhiteSpace(fileLine);
                 deque<InstrToken> fileLineContent;
                 if(tokenizeInstr(fileLine,fileLineContent)) {
@@ -1530,6 +1977,24 @@ namespace ProcDebug {
                 // vidage puis ajout de SIGQUIT au masque
                 Sigemptyset (&procData . back() -> sigMask);
                 Sigaddset   (&procData . back() -> sigMask, SIGQUIT);
+                const unsigned int progLength (
+                    countInstructions(procData . back() -> proGram));
+                if(progLength > maxProgLength) {
+                    maxProgLength = progLength;
+                }
+                // la table des lignes, une fois par fichier
+                if(lineTables . find(fileName) == lineTables . end()) {
+                    LineTable &table (lineTables[fileName]);
+                    table . source . swap(source);
+                    table . instrs . resize(table . source . size());
+                    fillLineTable(procData . back() -> proGram, &table);
+                    table . nextExec . resize(table . source . size());
+                    int next (-1);
+                    for(unsigned int k = table . source . size(); k--; ) {
+                        if(table . qExecutable(k)) next = k;
+                        table . nextExec[k] = next;
+                    }
+                }
                 if(qParsingVerbose) {
                     cerr << "ok.\n";
                 }
@@ -1575,14 +2040,553 @@ namespace ProcDebug {
     
     // fonction pour terminer un processus 
 
-    void ProcInfo::doTerminateProc(const int procPid) {
+    void ProcInfo::doTerminateProc(const int procPid,
+                                   const ProcExitCode exitCode
+                                                      /* = EXIT_NORMAL */) {
     if (STATUS == STAT_TRACEEND     ||
-        STATUS == STAT_TRACESTEPRUN)
+        STATUS == STAT_TRACESTEPRUN) {
+        output . flush();
         cout << "Processus terminé : "
              << procData[procPid] -> progName
              << '\n';
+    }
         procData[procPid] -> procStatus = STAT_TERMINATED;
-        --outstandingProcCount;
+        procData[procPid] -> exitCode   = exitCode;
+        procData[procPid] -> undoLog . clear(); // on ne ressuscite pas
+        if(procData[procPid] -> qReapable) { // libere par reapZombies()
+            while(__sync_lock_test_and_set(&zombieLock, 1)) {}
+            zombiePids . push_back(procPid);
+            __sync_lock_release(&zombieLock);
+        }
+        if(procData[procPid] -> procMutexStatus == STAT_MUTEXWAIT) {
+            scheduler -> noteMutexWait(-1);
+            procData[procPid] -> procMutexStatus = STAT_NOMUTEX;
+        }
+        // s'il detenait le mutex, mutexOwner le garde : le graphe
+        // d'attente montrera alors un detenteur termine
+        procData[procPid] -> qProgress = true;
+        __sync_fetch_and_sub(&outstandingProcCount, 1); // moteur parallele
+    }
+
+    // les instructions que l'execution de proGram peut atteindre :
+    // pas la racine PROGRAM, et pas le corps d'un SIGNAL (il ne
+    // s'execute que dans hanDler)
+
+    void ProcInfo::fillLineTable(const ProcInstruction *instr,
+                                 LineTable *pTable) {
+        if(instr -> instructionType != DO_PROGRAM &&
+           instr -> lineNumber < (int)pTable -> instrs . size()) {
+            pTable -> instrs[instr -> lineNumber] .
+                push_back(instr -> instructionType);
+        }
+        if(instr -> instructionType == DO_SIGNAL) return;
+        for(unsigned int k = 0; k < instr -> bodyInstr . size(); ++k) {
+            fillLineTable(instr -> bodyInstr[k], pTable);
+        }
+    }
+
+    const ProcInfo::LineTable *ProcInfo::findLineTable(
+        const string &progName) const {
+        const LineTables::const_iterator it (lineTables . find(progName));
+        return it == lineTables . end() ? 0 : &it -> second;
+    }
+
+    unsigned int ProcInfo::countInstructions(const ProcInstruction *instr) {
+        if(instr == 0) return 0;
+        unsigned int count (1);
+        for(unsigned int k = 0; k < instr -> bodyInstr . size(); ++k) {
+            count += countInstructions(instr -> bodyInstr[k]);
+        }
+        return count;
+    }
+
+    bool ProcInfo::qHasInstruction(const ProcInstruction *instr,
+                                   const ProcInstructionType type) {
+        if(instr == 0) return false;
+        if(instr -> instructionType == type) return true;
+        for(unsigned int k = 0; k < instr -> bodyInstr . size(); ++k) {
+            if(qHasInstruction(instr -> bodyInstr[k], type)) return true;
+        }
+        return false;
+    }
+
+    // les ecritures : une valeur qui change, c'est une progression ;
+    // elle est notee dans le processus (qui peut tourner sur un thread de
+    // travail), et transmise a l'ordonnanceur par flushProgress()
+
+    void ProcInfo::flushProgress(const int procPid) {
+        if(procData[procPid] -> qProgress) {
+            procData[procPid] -> qProgress = false;
+            scheduler -> noteProgress();
+        }
+    }
+
+    void ProcInfo::writeSymbol(const int procPid, const int symIndex,
+                               const int value) {
+        int & destination (procData[procPid] -> symbolTable[symIndex] . value);
+        if(destination != value) {
+            procData[procPid] -> qProgress = true;
+            if(undoLogSize) {
+                logUndo(procPid, UNDO_SYMBOL, symIndex, destination, value);
+            }
+            if(procData[procPid] -> symbolWatch . qWatched(symIndex)) {
+                noteWatchHit(procPid, WATCH_SYMBOL, symIndex,
+                             destination, value);
+            }
+        }
+        destination = value;
+    }
+
+    // la memoire partagee est la seule donnee ecrite par plusieurs
+    // processus : en mode parallele, lectures et ecritures y sont des
+    // operations atomiques avec barriere complete (coherence sequentielle)
+
+    void ProcInfo::writeMemory(const int procPid, const bool qShared,
+                               const int memIndex, const int value) {
+        if(qMemSnapshot) snapshotCell(procPid, qShared, memIndex);
+        int & destination (qShared ? sharedMemory[memIndex]
+                                   : procData[procPid] -> heapMemory[memIndex]);
+        int oldValue (destination);
+        if(qShared && qParallel) {
+            oldValue = __sync_lock_test_and_set(&destination, value);
+            __sync_synchronize();
+        }
+        else {
+            destination = value;
+        }
+        if(oldValue != value) {
+            procData[procPid] -> qProgress = true;
+            if(undoLogSize) {
+                logUndo(procPid, qShared ? UNDO_SHARED : UNDO_HEAP,
+                        memIndex, oldValue, value);
+            }
+            if(qShared ? sharedWatch . qWatched(memIndex)
+                       : procData[procPid] -> heapWatch . qWatched(memIndex)) {
+                noteWatchHit(procPid, qShared ? WATCH_SHARED : WATCH_HEAP,
+                             memIndex, oldValue, value);
+            }
+        }
+    }
+
+    // avant l'ecriture de la case : la page copiee est celle de l'arret.
+    // une page partagee peut etre ecrite par plusieurs threads a la fois :
+    // la copie est faite sous snapLock, et marquee une fois finie, si bien
+    // qu'un autre qui la voit marquee peut ecrire
+
+    void ProcInfo::snapshotCell(const int procPid, const bool qShared,
+                                const int cell) {
+        MemSnapshot & snap (qShared ? sharedSnap
+                                    : procData[procPid] -> heapSnap);
+        const unsigned int page (cell >> WATCH_PAGE_SHIFT);
+        if(page < snap . saved . size() && !snap . saved[page]) {
+            snapshotPage(snap, qShared ? sharedMemory
+                                       : procData[procPid] -> heapMemory,
+                         page, qShared && qParallel);
+        }
+    }
+
+    void ProcInfo::snapshotPage(MemSnapshot &snap, const vector<int> &memory,
+                                const unsigned int page, const bool qLock) {
+        if(qLock) {
+            while(__sync_lock_test_and_set(&snapLock, 1)) ;
+            if(*static_cast<volatile unsigned char *>(&snap . saved[page])) {
+                __sync_lock_release(&snapLock);
+                return;
+            }
+        }
+        const unsigned int first (page << WATCH_PAGE_SHIFT);
+        const unsigned int last (std::min<size_t>(
+                                     first + (1 << WATCH_PAGE_SHIFT),
+                                     memory . size()));
+        snap . pages[page] . assign(memory . begin() + first,
+                                    memory . begin() + last);
+        if(qLock) {
+            __sync_synchronize();
+            snap . saved[page] = 1;
+            __sync_lock_release(&snapLock);
+        }
+        else {
+            snap . saved[page] = 1;
+        }
+    }
+
+    // le thread principal, entre deux ticks : les pages de l'intervalle
+    // qui finit deviennent celles que diffMemory() compare
+
+    void ProcInfo::markStop() {
+        qMemSnapshot = true;
+        const unsigned int pageSize (1 << WATCH_PAGE_SHIFT);
+        for(unsigned int k = 0; k < procData . size(); ++k) {
+            if(!procData[k]) continue;
+            MemSnapshot & snap (procData[k] -> heapSnap);
+            snap . lastPages . swap(snap . pages);
+            snap . pages . clear();
+            snap . saved . assign((procData[k] -> heapMemory . size()
+                                   + pageSize - 1) / pageSize, 0);
+        }
+        sharedSnap . lastPages . swap(sharedSnap . pages);
+        sharedSnap . pages . clear();
+        sharedSnap . saved . assign((sharedMemory . size() + pageSize - 1)
+                                    / pageSize, 0);
+    }
+
+    void ProcInfo::diffMemory(const int procPid, vector<MemChange> *pChanges) {
+        pChanges -> clear();
+        for(int kind = 0; kind < 2; ++kind) {
+            const bool qShared (kind == 1);
+            const MemSnapshot & snap (qShared ? sharedSnap
+                                              : procData[procPid] -> heapSnap);
+            const vector<int> & memory (qShared ? sharedMemory
+                                        : procData[procPid] -> heapMemory);
+            for(map<int, vector<int> >::const_iterator
+                    it (snap . lastPages . begin());
+                it != snap . lastPages . end(); ++it) {
+                const int first (it -> first << WATCH_PAGE_SHIFT);
+                // une restauration a pu changer la taille depuis
+                for(unsigned int k = 0; k < it -> second . size() &&
+                        first + k < memory . size(); ++k) {
+                    if(it -> second[k] == memory[first + k]) continue;
+                    MemChange change;
+                    change . qShared  = qShared;
+                    change . cell     = first + k;
+                    change . oldValue = it -> second[k];
+                    change . newValue = memory[first + k];
+                    pChanges -> push_back(change);
+                }
+            }
+        }
+    }
+
+    // on ne garde que la premiere ecriture, jusqu'a ce que le debugger
+    // l'ait vue ; l'instruction courante est encore celle qui ecrit
+
+    void ProcInfo::noteWatchHit(const int procPid, const WatchKind kind,
+                                const int cell, const int oldValue,
+                                const int newValue) {
+        if(watchHit . procPid != invalidProcPid) return;
+        ProcInstruction * p (findCrtInstruction(procData[procPid] -> proGram));
+        watchHit . procPid    = procPid;
+        watchHit . kind       = kind;
+        watchHit . cell       = cell;
+        watchHit . oldValue   = oldValue;
+        watchHit . newValue   = newValue;
+        watchHit . lineNumber = p ? p -> lineNumber : -1;
+        watchHit . fileName   = p ? p -> fileName   : "";
+    }
+
+    bool ProcInfo::WatchSet::add(const int cell) {
+        vector<int>::iterator pos (lower_bound(cells . begin(),
+                                               cells . end(), cell));
+        if(pos != cells . end() && *pos == cell) return false;
+        cells . insert(pos, cell);
+        const unsigned int page (cell >> WATCH_PAGE_SHIFT);
+        if(page >= pageCount . size()) pageCount . resize(page + 1);
+        ++pageCount[page];
+        return true;
+    }
+
+    bool ProcInfo::WatchSet::remove(const int cell) {
+        vector<int>::iterator pos (lower_bound(cells . begin(),
+                                               cells . end(), cell));
+        if(pos == cells . end() || *pos != cell) return false;
+        cells . erase(pos);
+        --pageCount[cell >> WATCH_PAGE_SHIFT];
+        return true;
+    }
+
+    bool ProcInfo::setWatch(const int procPid, const WatchKind kind,
+                            const int cell, const bool qOn) {
+        WatchSet & watchSet (kind == WATCH_SHARED ? sharedWatch :
+                             kind == WATCH_HEAP ? procData[procPid] -> heapWatch
+                                                : procData[procPid] -> symbolWatch);
+        if(!(qOn ? watchSet . add(cell) : watchSet . remove(cell))) {
+            return false;
+        }
+        if(qOn) ++watchCount;
+        else    --watchCount;
+        return true;
+    }
+
+    // les tracepoints (voir tracePoints dans ProcDebug.h) ; les
+    // variables sont resolues dans la table du processus donne, la meme
+    // pour toutes les instances de son programme
+
+    int ProcInfo::addTracePoint(const int procPid, const int lineNumber,
+                                const vector<string> &names,
+                                string *pErrMsg) {
+        ProcData * pData (procData[procPid]);
+        const LineTable * table (findLineTable(pData -> progName));
+        if(!table || !table -> qExecutable(lineNumber)) {
+            *pErrMsg = "Pas d'instruction a cette ligne";
+            return -1;
+        }
+        if(names . empty() || names . size() > TRACE_MAX_VARS) {
+            ostringstream msg;
+            msg << "De 1 a " << TRACE_MAX_VARS << " variables";
+            *pErrMsg = msg . str();
+            return -1;
+        }
+        TracePoint point;
+        point . progName   = pData -> progName;
+        point . lineNumber = lineNumber;
+        point . names      = names;
+        for(unsigned int k = 0; k < names . size(); ++k) {
+            const int slot (pData -> findExistentSymbol(names[k]));
+            if(slot == -1) {
+                *pErrMsg = "Variable introuvable : " + names[k];
+                return -1;
+            }
+            point . slots . push_back(slot);
+        }
+        vector<int> & lines (traceLineMap[pData -> progName]);
+        if(lines . size() <= (unsigned int)lineNumber) {
+            lines . resize(table -> source . size());
+        }
+        if(lines[lineNumber]) {
+            *pErrMsg = "Tracepoint deja enregistre a cette ligne";
+            return -1;
+        }
+        if(traceRing . empty()) traceRing . resize(TRACE_RING_SIZE);
+        tracePoints . push_back(point);
+        lines[lineNumber] = tracePoints . size();
+        for(unsigned int k = 0; k < procData . size(); ++k) {
+            if(procData[k] && procData[k] -> progName == point . progName) {
+                procData[k] -> traceLines = &lines;
+            }
+        }
+        return tracePoints . size() - 1;
+    }
+
+    // le dernier d'un programme supprime, ses processus ne testent plus
+    // rien du tout
+
+    bool ProcInfo::removeTracePoint(const unsigned int point) {
+        if(point >= tracePoints . size() ||
+           tracePoints[point] . lineNumber < 0) {
+            return false;
+        }
+        TracePoint & tp (tracePoints[point]);
+        vector<int> & lines (traceLineMap[tp . progName]);
+        lines[tp . lineNumber] = 0;
+        tp . lineNumber = -1;
+        if(std::count(lines . begin(), lines . end(), 0) ==
+           (long)lines . size()) {
+            for(unsigned int k = 0; k < procData . size(); ++k) {
+                if(procData[k] && procData[k] -> traceLines == &lines) {
+                    procData[k] -> traceLines = 0;
+                }
+            }
+        }
+        return true;
+    }
+
+    // sur un thread de travail aussi : la case est reservee par un
+    // increment atomique, et personne ne lit l'anneau pendant un tick
+
+    void ProcInfo::noteTrace(const int procPid, const int lineNumber) {
+        const ProcData * pData (procData[procPid]);
+        const vector<int> & lines (*pData -> traceLines);
+        if((unsigned int)lineNumber >= lines . size() ||
+           !lines[lineNumber]) {
+            return;
+        }
+        const int point (lines[lineNumber] - 1);
+        const vector<int> & slots (tracePoints[point] . slots);
+        const unsigned long k (qParallel ? __sync_fetch_and_add(&traceNext, 1)
+                                         : traceNext++);
+        TraceRecord & record (traceRing[k & (TRACE_RING_SIZE - 1)]);
+        record . procPid    = procPid;
+        record . point      = point;
+        record . lineNumber = lineNumber;
+        record . step       = pData -> stepCount;
+        for(unsigned int v = 0; v < slots . size(); ++v) {
+            record . values[v] = pData -> symbolTable[slots[v]] . value;
+        }
+    }
+
+    void ProcInfo::dumpTrace(ostream *s, const bool qMachine) {
+        const unsigned long first (traceNext - traceDumped > TRACE_RING_SIZE
+                                   ? traceNext - TRACE_RING_SIZE
+                                   : traceDumped);
+        ostringstream out;
+        if(qMachine) {
+            if(first != traceDumped) {
+                out << "@tracelost count=" << first - traceDumped << '\n';
+            }
+        }
+        else {
+            out << "Trace: " << traceNext - first << " record(s), "
+                << first - traceDumped << " overwritten\n";
+        }
+        for(unsigned long k = first; k != traceNext; ++k) {
+            const TraceRecord & record (traceRing[k & (TRACE_RING_SIZE - 1)]);
+            const TracePoint  & tp (tracePoints[record . point]);
+            out << (qMachine ? "@trace pid=" : "  [") << record . procPid + 1
+                << (qMachine ? " step=" : "] step ") << record . step
+                << (qMachine ? " prog=" : " ") << tp . progName
+                << (qMachine ? " line=" : ":") << record . lineNumber;
+            for(unsigned int v = 0; v < tp . names . size(); ++v) {
+                out << ' ' << tp . names[v] << '=' << record . values[v];
+            }
+            out << '\n';
+        }
+        traceDumped = traceNext;
+        const string & text (out . str());
+        s -> write(text . data(), text . size());
+    }
+
+    // le journal d'annulation (voir UndoLog dans ProcDebug.h)
+
+    void ProcInfo::UndoLog::push(const UndoEntry &entry) {
+        if(count == ring . size()) {
+            // plein : on oublie le plus ancien pas, en entier
+            do {
+                first = (first + 1) % ring . size();
+                --count;
+            } while(count && ring[first] . kind != UNDO_STEP);
+            --steps;
+        }
+        ring[(first + count) % ring . size()] = entry;
+        ++count;
+        if(entry . kind == UNDO_STEP) ++steps;
+    }
+
+    void ProcInfo::logUndo(const int procPid, const UndoKind kind,
+                           const int cell, const int oldValue,
+                           const int newValue) {
+        UndoLog & undoLog (procData[procPid] -> undoLog);
+        if(undoLog . ring . empty()) return; // pas encore de pas journalise
+        UndoEntry entry;
+        entry . kind     = kind;
+        entry . condEval = COND_NOT_EVAL;
+        entry . cell     = cell;
+        entry . oldValue = oldValue;
+        entry . newValue = newValue;
+        entry . instr    = 0;
+        undoLog . push(entry);
+    }
+
+    bool ProcInfo::qIsIrreversible(const ProcInstructionType t) {
+        return t == DO_READ  || t == DO_PRINT  || t == DO_FORK ||
+               t == DO_MUTEX || t == DO_SIGADD || t == DO_SIGDEL ||
+               t == DO_DEVREAD || t == DO_DEVWRITE;
+    }
+
+    // le noeud ou doOneStepAndAdvancePC() descendra depuis p, 0 si elle
+    // s'arrete a p (instruction simple, ou condition de WHILE a evaluer) ;
+    // contrairement a findCrtInstruction(), un corps qu'on va commencer
+    // (programCounter a -1) compte deja
+
+    ProcInfo::ProcInstruction *ProcInfo::stepChild(ProcInstruction *p) {
+        if((p -> instructionType != DO_WHILEREPEAT &&
+            p -> instructionType != DO_PROGRAM) ||
+           (p -> instructionType == DO_WHILEREPEAT &&
+            p -> condEval != COND_EVAL_TRUE) ||
+           p -> bodyInstr . empty()) return 0;
+        return p -> bodyInstr[p -> programCounter < 0 ? 0
+                                                      : p -> programCounter];
+    }
+
+    // la marque du pas, puis les noeuds que doOneStepAndAdvancePC() peut
+    // toucher : ceux qu'elle traverse, de la racine a l'instruction faite
+
+    void ProcInfo::logUndoStep(const int procPid, ProcInstruction *prog) {
+        UndoLog & undoLog (procData[procPid] -> undoLog);
+        UndoEntry entry;
+        entry . kind     = UNDO_STEP;
+        entry . condEval = COND_NOT_EVAL;
+        entry . cell     = procData[procPid] -> nextLineNumber;
+        entry . oldValue = entry . newValue = 0;
+        entry . instr    = 0;
+        undoLog . push(entry);
+        entry . kind = UNDO_PC;
+        for(ProcInstruction * p (prog); p; p = stepChild(p)) {
+            if(p -> instructionType != DO_WHILEREPEAT &&
+               p -> instructionType != DO_PROGRAM) break;
+            entry . condEval = p -> condEval;
+            entry . cell     = p -> programCounter;
+            entry . instr    = p;
+            undoLog . push(entry);
+        }
+    }
+
+    void ProcInfo::doOneLoggedStep(const int procPid, ProcInstruction *prog) {
+        if(!undoLogSize) {
+            doOneStepAndAdvancePC(procPid, prog);
+            return;
+        }
+        UndoLog & undoLog (procData[procPid] -> undoLog);
+        ProcInstruction * p (prog);
+        while(ProcInstruction * child = stepChild(p)) p = child;
+        if(qIsIrreversible(p -> instructionType)) {
+            doOneStepAndAdvancePC(procPid, prog);
+            undoLog . clear(); // on ne reviendra pas avant ce pas
+            return;
+        }
+        if(undoLog . ring . size() != undoLogSize) {
+            undoLog . clear();
+            undoLog . ring . resize(undoLogSize);
+        }
+        logUndoStep(procPid, prog);
+        doOneStepAndAdvancePC(procPid, prog);
+    }
+
+    bool ProcInfo::undoStep(const int procPid, string *pErrMsg) {
+        ProcData * pData (procData[procPid]);
+        UndoLog & undoLog (pData -> undoLog);
+        if(!undoLog . steps) {
+            *pErrMsg = "Plus rien a defaire";
+            return false;
+        }
+        const unsigned int ringSize (undoLog . ring . size());
+        const unsigned int last (undoLog . first + undoLog . count - 1);
+        unsigned int nb (0); // entrees du dernier pas, sans sa marque
+        while(undoLog . ring[(last - nb) % ringSize] . kind != UNDO_STEP) ++nb;
+        for(unsigned int k = 0; k < nb; ++k) {
+            const UndoEntry & entry (undoLog . ring[(last - k) % ringSize]);
+            if(entry . kind == UNDO_SHARED &&
+               readShared(entry . cell) != entry . newValue) {
+                ostringstream msg;
+                msg << "_$" << entry . cell - sharedMemoryBase
+                    << " a ete modifiee depuis par un autre processus";
+                *pErrMsg = msg . str();
+                return false;
+            }
+        }
+        for(unsigned int k = 0; k < nb; ++k) {
+            const UndoEntry & entry (undoLog . ring[(last - k) % ringSize]);
+            switch(entry . kind) {
+                case UNDO_PC:
+                    entry . instr -> programCounter = entry . cell;
+                    entry . instr -> condEval =
+                        static_cast<ProcCondEval>(entry . condEval);
+                    break;
+                case UNDO_SYMBOL:
+                    pData -> symbolTable[entry . cell] . value =
+                        entry . oldValue;
+                    break;
+                case UNDO_HEAP:
+                    if(qMemSnapshot) snapshotCell(procPid, false, entry . cell);
+                    pData -> heapMemory[entry . cell] = entry . oldValue;
+                    break;
+                case UNDO_SHARED:
+                    if(qMemSnapshot) snapshotCell(procPid, true, entry . cell);
+                    sharedMemory[entry . cell] = entry . oldValue;
+                    break;
+                default: ;
+            }
+        }
+        pData -> nextLineNumber = undoLog . ring[(last - nb) % ringSize] . cell;
+        undoLog . count -= nb + 1;
+        --undoLog . steps;
+        return true;
+    } // undoStep()
+
+    int ProcInfo::readShared(const int memIndex) {
+        if(qParallel) {
+            return __sync_fetch_and_add(&sharedMemory[memIndex], 0);
+        }
+        return sharedMemory[memIndex];
     }
 
 
@@ -1614,32 +2618,25 @@ namespace ProcDebug {
         }
         switch(crtInstr -> instructionType) {
             case DO_NEW: {
-                procData[procPid] -> 
-                        symbolTable[
-                            crtInstr -> leftValue] . value = 
-                    procData[procPid] -> symbolTable[
-                        crtInstr -> operand[0]] . value;
+                writeSymbol(procPid, crtInstr -> leftValue,
+                            procData[procPid] -> symbolTable[
+                                crtInstr -> operand[0]] . value);
                 break;
             }// DO_NEW
             case DO_COMP: {
                 bool qError (false);
                 int result(doTheExpressionOfThe(procPid,crtInstr,&qError));
                 if(!qError) {
-                    procData[procPid] -> 
-                        symbolTable[
-                            crtInstr -> leftValue] . value = 
-                        result;
+                    writeSymbol(procPid, crtInstr -> leftValue, result);
                 }
                 returnValue = qError;
                 break;
             }// DO_COMP
             case DO_COPY:
-                procData[procPid] -> 
-                        symbolTable[
-                            crtInstr -> leftValue] . value = 
-                    procData[procPid] -> 
-                        symbolTable[
-                            crtInstr -> operand[0]] . value;
+                writeSymbol(procPid, crtInstr -> leftValue,
+                            procData[procPid] -> 
+                                symbolTable[
+                                    crtInstr -> operand[0]] . value);
                     break;
                 // DO_COPY
             case DO_READ: {
@@ -1649,25 +2646,58 @@ namespace ProcDebug {
                 // "Sécurisation" de l'entrée au clavier, par contre
                 // maintenant, on ne peux plus entrer juste "4 5" par exemple,
                 // il faut taper <Entrer> entre les deux entiers
-                while (true) {
-                    string Str;
-                    getline(cin, Str);
-                    if (Str.empty()) {
-                        cin.clear();
-                        cerr << "INPUT ERROR expected int, try again\n";
-                        continue;
+                // (en rejeu, la valeur vient du journal, sinon d'abord de
+                // la source --input= du programme, s'il y en a une)
+                int value;
+                InputFeed * feed (input ? input -> find(procData[procPid]
+                                                        -> progName) : 0);
+                bool qInputEnd (false); // journalisee elle aussi
+                bool qGot (journal && journal -> qReplaying() &&
+                           journal -> replayRead(&value, &qInputEnd) &&
+                           !qInputEnd);
+                if (!qGot && !qInputEnd && feed &&
+                    (qGot = feed -> next(&value)) &&
+                    journal && journal -> qRecording()) {
+                    journal -> recordRead(value);
+                }
+                // l'entree standard : en asynchrone (voir pollInput()),
+                // sans ligne on reste la, en STAT_IOWAIT
+                const bool qAsync (qAsyncRead && oldStat == STAT_RUNNING);
+                // l'invite d'un PRINT precedent
+                if (!qGot && !qInputEnd) output . flush();
+                for (string Str; !qGot && !qInputEnd; ) {
+                    if (qAsync ? !stdinLines . takeLine(&Str)
+                               : !stdinLines . getLine (&Str)) {
+                        if (stdinLines . qAtEnd()) {
+                            qInputEnd = true;
+                            if (journal && journal -> qRecording()) {
+                                journal -> recordInputEnd();
+                            }
+                            break;
+                        }
+                        ioWaitPids . push_back(procPid);
+                        return false; // le compteur ordinal n'avance pas
                     }
-
                     istringstream sstr (Str);
-                    sstr >> (procData[procPid] ->
-                             symbolTable[
-                                 crtInstr -> leftValue] . value);
-                    if (sstr.fail()) {
+                    sstr >> value;
+                    if (Str.empty() || sstr.fail()) {
                         cerr << "INPUT ERROR expected int, try again\n";
                         continue;
                     }
-                    break;
+                    qGot = true;
+                    if (journal && journal -> qRecording()) {
+                        journal -> recordRead(value);
+                    }
+                }
+                if (qInputEnd) {
+                    output . flush();
+                    cerr << "INPUT ERROR end of input, "
+                         << procData[procPid] -> progName << " stops\n";
+                    procData[procPid] -> procStatus = oldStat;
+                    return true;
                 }
+                writeSymbol(procPid, crtInstr -> leftValue, value);
+                procData[procPid] -> qProgress = true; // l'entree vient de l'exterieur
 
                 procData[procPid] -> procStatus = oldStat;
                 break;
@@ -1675,19 +2705,35 @@ namespace ProcDebug {
             case DO_PRINT: {
                 ProcStatus oldStat (procData[procPid] -> procStatus);
                 procData[procPid] -> procStatus = STAT_IOWAIT; 
-                for(unsigned int k = 0;k < crtInstr -> operand . size(); ++k){
-                    if(procData[procPid] -> 
-                       symbolTable[crtInstr -> operand[k]] . opType
-                       == OPND_TYPE_INT) {
-                        cout << procData[procPid] ->
-                            symbolTable[crtInstr -> operand[k]] . value ;
+                const ProcData * pData (procData[procPid]);
+                if(capture) { // le texte entier, pour le thread ecrivain
+                    string text (pData -> printMaxLength(crtInstr), '\0');
+                    if(text . size()) {
+                        text . resize(pData -> fillPrint(crtInstr,
+                                                         &text[0]) -
+                                      &text[0]);
                     }
-                    else {
-                        cout << procData[procPid] ->
-                            symbolTable[crtInstr -> operand[k]] . strValue;
+                    capture -> put(procPid, &text);
+                }
+                else {
+                    output . beginPrint();
+                    char * const p (output . reserve(
+                                        pData -> printMaxLength(crtInstr)));
+                    if(p) {
+                        output . commit(pData -> fillPrint(crtInstr, p),
+                                        crtInstr -> qPrintNewLine);
                     }
+                    else { // plus grand que le tampon : morceau par morceau
+                        string text (pData -> printMaxLength(crtInstr),
+                                     '\0');
+                        text . resize(pData -> fillPrint(crtInstr,
+                                                         &text[0]) -
+                                      &text[0]);
+                        output . put(text);
+                    }
+                    output . endPrint();
                 }
-                cout << flush;
+                procData[procPid] -> qProgress = true;
                 procData[procPid] -> procStatus = oldStat;
                 break;
             } // DO_PRINT
@@ -1716,13 +2762,10 @@ namespace ProcDebug {
                          << crtInstr -> lineNumber+1 << "\n";
                     return true;
                 }
-                vector<int>::iterator destination(crtInstr -> leftValue == 
-                    THE_SHARED_MEMORY?
-                    sharedMemory . begin():
-                    procData[procPid] -> heapMemory . begin());
-                destination += memBase+memIndex;
-                (*destination) =  procData[procPid] ->
-                    symbolTable[crtInstr -> operand[1]] . value;
+                writeMemory(procPid, crtInstr -> leftValue == THE_SHARED_MEMORY,
+                            memBase+memIndex,
+                            procData[procPid] ->
+                                symbolTable[crtInstr -> operand[1]] . value);
                 break;
             }// DO_STORE
             case DO_LOAD: {
@@ -1751,39 +2794,37 @@ namespace ProcDebug {
                          << crtInstr -> lineNumber+1 << "\n";
                     return true;
                 }
-                vector<int>::iterator source(crtInstr -> operand[0] ==  
-                    THE_SHARED_MEMORY?
-                    sharedMemory . begin():
-                    procData[procPid] -> heapMemory . begin());
-                source += memBase+memIndex;
-                procData[procPid] ->
-                    symbolTable[crtInstr -> leftValue] . value = 
-                    (*source);
+                writeSymbol(procPid, crtInstr -> leftValue,
+                            crtInstr -> operand[0] == THE_SHARED_MEMORY?
+                            readShared(memBase+memIndex):
+                            procData[procPid] -> heapMemory[memBase+memIndex]);
                 break;
             }// DO_LOAD
-            case DO_FORK:
+            case DO_FORK: {
                 procData[procPid] -> symbolTable[
                     crtInstr -> leftValue] . value = 0;
-                    procData . resize(procData . size() + 1);
-                procData[procData . size() - 1] = new ProcData(
-                    *(procData[procPid]));
+                // un pid libere s'il y en a, sinon une nouvelle place
+                const int childPid (allocPid());
+                procData[childPid] = new ProcData(*(procData[procPid]));
                 procData[procPid] -> symbolTable[
-                    crtInstr -> leftValue] . value = procData . size() - 1;
+                    crtInstr -> leftValue] . value = childPid;
                 // le nouveau fils vient d'etre cree par dedoublement
-                procData . back() -> procStatus = STAT_WAITING; 
-                scheduler -> enQueueProc(procData . size() - 1);
+                procData[childPid] -> procStatus = STAT_WAITING; 
+                procData[childPid] -> qReapable  = true;
+                scheduler -> enQueueProc(childPid);
                 ++outstandingProcCount;
                 // et maintenant on prend soin du pere aussi
                 procData[procPid] ->  procStatus = STAT_SYS;
+                procData[procPid] -> qProgress = true;
                 if(forkedInstr) {
                     (*forkedInstr) = 
-                        findCrtInstruction(procData . back() -> proGram);
+                        findCrtInstruction(procData[childPid] -> proGram);
                 }
                 if(forkedPid) {
-                    *forkedPid = procData . size() - 1;
+                    *forkedPid = childPid;
                 }
                 break;
-                // DO_FORK
+            }// DO_FORK
             case DO_MUTEX: {
                 const int mutexOper (crtInstr -> operand[0]);
                 if(crtInstr -> leftValue != THE_MUTEX) {
@@ -1795,17 +2836,32 @@ namespace ProcDebug {
                     return true;
                 }
                 switch(mutexOper){
-                    case MUTEX_OPER_P: if(mutex == 1) {
-                        mutex = 0;
+                    // compare-and-swap, pour le moteur parallele
+                    case MUTEX_OPER_P: if(__sync_bool_compare_and_swap(
+                                              &mutex, 1, 0)) {
+                        __sync_lock_test_and_set(&mutexOwner, procPid);
+                        if(procData[procPid] -> procMutexStatus == 
+                           STAT_MUTEXWAIT) {
+                            scheduler -> noteMutexWait(-1);
+                        }
                         procData[procPid] -> procMutexStatus = STAT_MUTEXGRAB;
+                        procData[procPid] -> qProgress = true;
                     }
                     else {
+                        if(procData[procPid] -> procMutexStatus != 
+                           STAT_MUTEXWAIT) {
+                            scheduler -> noteMutexWait(+1);
+                        }
                         procData[procPid] -> procMutexStatus = STAT_MUTEXWAIT;
                     }
                         break;
-                    case MUTEX_OPER_V: if(mutex == 0) {
-                        mutex = 1; 
+                    case MUTEX_OPER_V:
+                        __sync_lock_test_and_set(&mutexOwner, invalidProcPid);
+                        // efface avant de liberer, pour ne pas effacer
+                        // celui qui le prendrait juste apres
+                        if(__sync_bool_compare_and_swap(&mutex, 0, 1)) {
                         procData[procPid] -> procMutexStatus = STAT_NOMUTEX;
+                        procData[procPid] -> qProgress = true;
                         break;
                     default: cerr << "INTERNAL ERROR Unexpected mutex"
                                   << " operation value " 
@@ -1820,13 +2876,65 @@ namespace ProcDebug {
             case DO_SIGADD: {
                 Sigaddset (&procData[procPid] -> sigMask,
                                            crtInstr -> leftValue);
+                procData[procPid] -> qProgress = true;
                 break;
             }// DO_SIGADD
             case DO_SIGDEL: {
                 Sigdelset (&procData[procPid] -> sigMask,
                                             crtInstr -> leftValue);
+                procData[procPid] -> qProgress = true;
                 break;
             }// DO_SIGDEL
+            case DO_DEVREAD:
+            case DO_DEVWRITE: {
+                ProcData * pData (procData[procPid]);
+                const int memBase (pData ->
+                        symbolTable[crtInstr -> leftValue] . value);
+                const int blockNum (pData ->
+                        symbolTable[crtInstr -> operand[0]] . value);
+                const int nbWords (device . blockWords());
+                if(blockNum < 0 || blockNum >= (int)device . blockCount()) {
+                    cerr << "RUN ERROR block out of bounds in "
+                         << instructionKeyword[crtInstr -> instructionType]
+                         << ", " << crtInstr -> fileName << ":"
+                         << crtInstr -> lineNumber+1 << "\n";
+                    return true;
+                }
+                if(memBase < 0 || memBase + nbWords > pData -> heapMemoryLimit) {
+                    cerr << "RUN ERROR memBase out of bounds in "
+                         << instructionKeyword[crtInstr -> instructionType]
+                         << ", " << crtInstr -> fileName << ":"
+                         << crtInstr -> lineNumber+1 << "\n";
+                    return true;
+                }
+                // elu normalement : la requete part au disque, et on
+                // attend, sans avancer, qu'elle soit finie
+                if(pData -> devState != DEV_DONE &&
+                   pData -> procStatus == STAT_RUNNING) {
+                    if(pData -> devState == DEV_IDLE) {
+                        device . submit(procPid, crtInstr -> instructionType
+                                                 == DO_DEVWRITE,
+                                        scheduler -> getTick());
+                        pData -> devState = DEV_PENDING;
+                    }
+                    pData -> procStatus = STAT_IOWAIT;
+                    return false; // le compteur ordinal n'avance pas
+                }
+                vector<int> & block (device . block(blockNum));
+                for(int k = 0; k < nbWords; ++k) {
+                    if(crtInstr -> instructionType == DO_DEVREAD) {
+                        writeMemory(procPid, false, memBase + k, block[k]);
+                    }
+                    else {
+                        block[k] = pData -> heapMemory[memBase + k];
+                    }
+                }
+                // une requete encore en cours (le debugger l'a doublee) :
+                // sa fin ne reveillera personne
+                pData -> devState = DEV_IDLE;
+                pData -> qProgress = true;
+                break;
+            }// DO_DEVREAD, DO_DEVWRITE
             default: ;
         } // switch(type de l'instruction)
         if(qDoSleepAfterEachInstruction) {
@@ -1841,81 +2949,25 @@ namespace ProcDebug {
                                        bool            *pQError) {
         int result(0);
         switch(crtInstr -> operType) {
-            case OP_ADD:
-                return (procData[procPid] -> symbolTable[
-                            crtInstr -> operand[0]] . value
-                        + procData[procPid] -> symbolTable[
-                            crtInstr -> operand[1]] . value);
-            case OP_SUB:
-                return (procData[procPid] -> symbolTable[
-                            crtInstr -> operand[0]] . value 
-                        - procData[procPid] -> symbolTable[
-                            crtInstr -> operand[1]] . value);
-            case OP_MUL:
-                return (procData[procPid] -> symbolTable[
-                            crtInstr -> operand[0]] . value 
-                        * procData[procPid] -> symbolTable[
-                            crtInstr -> operand[1]] . value);
-            case OP_DIV:
-                if(procData[procPid] -> symbolTable[
-                       crtInstr -> operand[1]] . value) {
-                    return (procData[procPid] -> symbolTable[
-                            crtInstr -> operand[0]] . value
-                            / procData[procPid] -> symbolTable[
-                            crtInstr -> operand[1]] . value);
-                }
-                else {
-                    (*pQError) = true;
-                    cerr << "RUN ERROR Division by zero in '/', "
-                         << crtInstr -> fileName << ":" 
-                         << crtInstr -> lineNumber+1 << "\n";
-                    return 0;
+            case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_REM:
+            case OP_GT:  case OP_LT:  case OP_GE:  case OP_LE:
+            case OP_EQ:  case OP_DIFF: {
+                const vector<ProcSymbol> & symbols (
+                    procData[procPid] -> symbolTable);
+                if(applyOper(crtInstr -> operType,
+                             symbols[crtInstr -> operand[0]] . value,
+                             symbols[crtInstr -> operand[1]] . value,
+                             &result)) {
+                    return result;
                 }
-            case OP_REM:
-                if(procData[procPid] -> symbolTable[
-                       crtInstr -> operand[1]] . value) {
-                    return (procData[procPid] -> symbolTable[
-                            crtInstr -> operand[0]] . value 
-                            % procData[procPid] -> symbolTable[
-                            crtInstr -> operand[1]] . value);
-                }
-                else {
-                    (*pQError) = true;
-                    cerr << "RUN ERROR Division by zero in '%', "
-                         << crtInstr -> fileName << ":" 
-                         << crtInstr -> lineNumber+1 << "\n";
-                    return 0;
-                }
-            case OP_GT:
-                return (procData[procPid] -> symbolTable[
-                            crtInstr -> operand[0]] . value 
-                        > procData[procPid] -> symbolTable[
-                            crtInstr -> operand[1]] . value);
-            case OP_LT:
-                return (procData[procPid] -> symbolTable[
-                            crtInstr -> operand[0]] . value 
-                        < procData[procPid] -> symbolTable[
-                            crtInstr -> operand[1]] . value);
-            case OP_GE:
-                return (procData[procPid] -> symbolTable[
-                            crtInstr -> operand[0]] . value 
-                        >= procData[procPid] -> symbolTable[
-                            crtInstr -> operand[1]] . value);
-            case OP_LE:
-                return (procData[procPid] -> symbolTable[
-                            crtInstr -> operand[0]] . value 
-                        <= procData[procPid] -> symbolTable[
-                            crtInstr -> operand[1]] . value);
-            case OP_EQ:
-                return (procData[procPid] -> symbolTable[
-                            crtInstr -> operand[0]] . value 
-                        == procData[procPid] -> symbolTable[
-                            crtInstr -> operand[1]] . value);
-            case OP_DIFF:
-                return (procData[procPid] -> symbolTable[
-                            crtInstr -> operand[0]] . value 
-                        != procData[procPid] -> symbolTable[
-                            crtInstr -> operand[1]] . value);
+                // seule erreur possible ici : '/' ou '%' par zero
+                (*pQError) = true;
+                cerr << "RUN ERROR Division by zero in '"
+                     << operChar[crtInstr -> operType] << "', "
+                     << crtInstr -> fileName << ":" 
+                     << crtInstr -> lineNumber+1 << "\n";
+                return 0;
+            }
             case OP_NOP:
             case OP_INSTR:
             case OP_ENUM:
@@ -1941,6 +2993,220 @@ namespace ProcDebug {
         return(result);        
     } // doTheExpressionOfThe()
 
+    // le texte tape dans le debugger ne doit pas arriver tel quel a
+    // tokenizeInstr() : un nom qui n'est pas que des lettres ou un blanc
+    // entre deux operateurs y font un symbole invalide, et InstrToken
+    // termine alors la simulation entiere. On ne garde donc que les
+    // caracteres d'une expression et des noms faits de lettres, sans les
+    // blancs ("a - -3" devient "a--3"), qui ne peuvent separer deux mots
+
+    bool normalizeDbgExpr(const string &text, string *pOut,
+                          string *pErrMsg) {
+        const string operChars ("+-*/%<>=!$");
+        string out;
+        bool qBlank (false);
+        for(string::size_type k (0); k < text . size();) {
+            const unsigned char c (text[k]);
+            if(c == ' ' || c == '\t') {
+                qBlank = true;
+                ++k;
+                continue;
+            }
+            if(operChars . find(c) != string::npos) {
+                out += c;
+                qBlank = false;
+                ++k;
+                continue;
+            }
+            if(!isalnum(c) && c != '_') {
+                *pErrMsg = string("Caractere invalide : ") + char(c);
+                return false;
+            }
+            // un mot : que des lettres, que des chiffres, ou bien "_"
+            string::size_type kEnd (k);
+            unsigned int nbLetters (0);
+            for(; kEnd < text . size() &&
+                    (isalnum((unsigned char) text[kEnd]) ||
+                     text[kEnd] == '_'); ++kEnd) {
+                if(isalpha((unsigned char) text[kEnd])) ++nbLetters;
+            }
+            const string word (text . substr(k, kEnd - k));
+            if(nbLetters != 0 ? nbLetters != word . size()
+               : word . find('_') != string::npos && word != "_") {
+                *pErrMsg = "Nom invalide : " + word;
+                return false;
+            }
+            if(qBlank && !out . empty() &&
+               operChars . find(out[out . size() - 1]) == string::npos) {
+                *pErrMsg = "Operateur attendu : " + word;
+                return false;
+            }
+            out += word;
+            qBlank = false;
+            k = kEnd;
+        }
+        *pOut = out;
+        return true;
+    } // normalizeDbgExpr()
+
+    // la meme chose pour le debugger (voir CompiledExpr), compilee une
+    // fois pour toutes : les lexemes de tokenizeInstr(), comme pour une
+    // ligne de programme, mais dont les nombres ne deviennent pas des
+    // symboles (la table du processus reste telle quelle)
+
+    bool ProcInfo::compileExpr(const int procPid, const string &text,
+                               CompiledExpr *pExpr, string *pErrMsg) {
+        string normalized;
+        if(!normalizeDbgExpr(text, &normalized, pErrMsg)) return false;
+        deque<InstrToken> token;
+        if(tokenizeInstr(normalized, token) || token . empty()) {
+            *pErrMsg = "Expression invalide : " + text;
+            return false;
+        }
+        CompiledExpr expr;
+        unsigned int pos (0);
+        if(!compileOperand(procPid, token, &pos, &expr . left, pErrMsg)) {
+            return false;
+        }
+        if(pos < token . size()) {
+            // les operateurs de applyOper() : OP_ADD et les suivants
+            if(token[pos] . tokenType != INSTRTOK_OPER ||
+               token[pos] . tokenOperType < OP_ADD) {
+                *pErrMsg = "Operateur attendu : " + token[pos] . token;
+                return false;
+            }
+            expr . operType = token[pos++] . tokenOperType;
+            if(!compileOperand(procPid, token, &pos, &expr . right,
+                               pErrMsg)) {
+                return false;
+            }
+        }
+        if(pos < token . size()) {
+            *pErrMsg = "En trop dans l'expression : " + token[pos] . token;
+            return false;
+        }
+        *pExpr = expr;
+        return true;
+    } // compileExpr()
+
+    // une operande a partir de token[*pPos], qui passe apres ; un nombre
+    // peut etre precede de '-' (le decoupage en fait un operateur)
+
+    bool ProcInfo::compileOperand(const int procPid,
+                                  const deque<InstrToken> &token,
+                                  unsigned int *pPos, ExprOperand *pOperand,
+                                  string *pErrMsg) {
+        unsigned int pos (*pPos);
+        const bool qMinus (pos + 1 < token . size() &&
+                           token[pos] . tokenType == INSTRTOK_OPER &&
+                           token[pos] . tokenOperType == OP_SUB &&
+                           token[pos + 1] . tokenType == INSTRTOK_NUMBER);
+        if(qMinus) ++pos;
+        if(pos >= token . size()) {
+            *pErrMsg = "Operande attendue";
+            return false;
+        }
+        const InstrToken & first (token[pos++]);
+        ExprOperand operand;
+        if(first . tokenType == INSTRTOK_NUMBER) {
+            istringstream istr (first . token);
+            if(!(istr >> operand . value) || !istr . eof()) {
+                *pErrMsg = "Nombre invalide : " + first . token;
+                return false;
+            }
+            if(qMinus) operand . value = -operand . value;
+            operand . kind = EXPR_CONST;
+        }
+        else if(pos < token . size() &&
+                token[pos] . tokenType == INSTRTOK_OPER &&
+                token[pos] . tokenOperType == OP_MEMINDEX) {
+            // <var>$<indice> ou _$<indice>
+            if(first . tokenType == INSTRTOK_SPECIAL) {
+                if(first . token != "_") {
+                    *pErrMsg = "Memoire invalide : " + first . token;
+                    return false;
+                }
+                operand . kind = EXPR_SHARED;
+            }
+            else if(first . tokenType != INSTRTOK_SYMBOL ||
+                    -1 == (operand . value = procData[procPid] ->
+                           findExistentSymbol(first . token))) {
+                *pErrMsg = "Variable introuvable " + first . token;
+                return false;
+            }
+            else {
+                operand . kind = EXPR_HEAP;
+            }
+            if(++pos >= token . size()) {
+                *pErrMsg = "Indice attendu apres $";
+                return false;
+            }
+            const InstrToken & index (token[pos++]);
+            istringstream istr (index . token);
+            if(index . tokenType == INSTRTOK_NUMBER) {
+                if(!(istr >> operand . indexValue) || !istr . eof()) {
+                    *pErrMsg = "Indice invalide : " + index . token;
+                    return false;
+                }
+            }
+            else if(index . tokenType != INSTRTOK_SYMBOL ||
+                    -1 == (operand . indexSlot = procData[procPid] ->
+                           findExistentSymbol(index . token))) {
+                *pErrMsg = "Indice invalide : " + index . token;
+                return false;
+            }
+        }
+        else if(first . tokenType != INSTRTOK_SYMBOL ||
+                -1 == (operand . value = procData[procPid] ->
+                       findExistentSymbol(first . token))) {
+            *pErrMsg = "Variable introuvable " + first . token;
+            return false;
+        }
+        else {
+            operand . kind = EXPR_SYMBOL;
+        }
+        *pOperand = operand;
+        *pPos     = pos;
+        return true;
+    } // compileOperand()
+
+    // le debugger lit entre deux ticks : pas besoin de readShared()
+
+    bool ProcInfo::evalOperand(const int procPid, const ExprOperand &operand,
+                               int *pValue) const {
+        const ProcData * pData (procData[procPid]);
+        if(operand . kind == EXPR_CONST) {
+            *pValue = operand . value;
+            return true;
+        }
+        if(operand . kind == EXPR_SYMBOL) {
+            *pValue = pData -> symbolTable[operand . value] . value;
+            return true;
+        }
+        const int index (operand . indexSlot < 0 ? operand . indexValue :
+                         pData -> symbolTable[operand . indexSlot] . value);
+        const vector<int> & memory (operand . kind == EXPR_SHARED
+                                    ? sharedMemory : pData -> heapMemory);
+        const int cell (index + (operand . kind == EXPR_SHARED
+                                 ? sharedMemoryBase
+                                 : pData -> symbolTable[operand . value]
+                                   . value));
+        if(cell < 0 || cell >= (int)memory . size()) return false;
+        *pValue = memory[cell];
+        return true;
+    }
+
+    bool ProcInfo::evalExpr(const int procPid, const CompiledExpr &expr,
+                            int *pValue) const {
+        if(expr . operType == OP_NOP) {
+            return evalOperand(procPid, expr . left, pValue);
+        }
+        int left, right;
+        return evalOperand(procPid, expr . left, &left) &&
+               evalOperand(procPid, expr . right, &right) &&
+               applyOper(expr . operType, left, right, pValue);
+    }
+
     // La fonction qui suit maintenant, nommee doOneStepAndAdvancePC() 
     // est le "coeur" du mecanisme : elle execute l'instruction courante, 
     // et puis avance le ou les programCounter d'un cran;
@@ -1976,14 +3242,19 @@ namespace ProcDebug {
            crtInstr -> instructionType != DO_PROGRAM) {
             if(doTheInstruction(procPid,crtInstr,forkedPid,forkedInstr)) {
                 // c'est qu'il y a eu une erreur grave
-                doTerminateProc(procPid);
+                doTerminateProc(procPid, EXIT_ERROR);
                 return ADV_ONE_MORE_STEP_INSIDE;
             }
-            if(procData[procPid] -> procMutexStatus == STAT_MUTEXWAIT) {
+            if(procData[procPid] -> procMutexStatus == STAT_MUTEXWAIT ||
+               procData[procPid] -> procStatus      == STAT_IOWAIT) {
                 // alors on n'avance pas le compteur ordinal, et on patiente
                 return ADV_ONE_MORE_STEP_INSIDE; // facon de parler
                 // en fait c'est pour dire "il n'y a rien a faire"
             }
+            ++procData[procPid] -> stepCount;
+            if(procData[procPid] -> traceLines) {
+                noteTrace(procPid, crtInstr -> lineNumber);
+            }
             if(crtInstr->instructionType == DO_FORK && *forkedInstr) {
                 // travail effectif, et il s'agissait d'un FORK
                 (*forkedInstr) = (*forkedInstr) -> father;
@@ -2006,7 +3277,13 @@ namespace ProcDebug {
                         (doTheExpressionOfThe(procPid,crtInstr,&qError)?
                          COND_EVAL_TRUE:COND_EVAL_FALSE);
                     if(qError) {
-                        doTerminateProc(procPid);
+                        doTerminateProc(procPid, EXIT_ERROR);
+                    }
+                    else {
+                        ++procData[procPid] -> stepCount;
+                        if(procData[procPid] -> traceLines) {
+                            noteTrace(procPid, crtInstr -> lineNumber);
+                        }
                     }
                     if(crtInstr -> condEval == COND_EVAL_TRUE) {
                         if(crtInstr -> bodyInstr . size()) {
@@ -2161,14 +3438,72 @@ namespace ProcDebug {
     }
     
     
+    void Scheduler::setCpuCount(const int nbCpu) {
+        // on ne change le nombre de CPUs qu'au demarrage, mais on garde
+        // quand meme ce qui serait deja en file
+        deque<int> pending;
+        for(unsigned int kCpu = 0; kCpu < waitQueue . size(); ++kCpu) {
+            pending . insert(pending . end(), waitQueue[kCpu] . begin(),
+                             waitQueue[kCpu] . end());
+        }
+        waitQueue . assign(nbCpu < 1 ? 1 : nbCpu, deque<int>());
+        cpuStat   . assign(waitQueue . size(), CpuStat());
+        for(unsigned int kProc = 0; kProc < procAffinity . size(); ++kProc) {
+            procAffinity[kProc] . cpu = -1;
+        }
+        for(unsigned int kProc = 0; kProc < pending . size(); ++kProc) {
+            enQueueProc(pending[kProc]);
+        }
+    }
+
+    // un pid libere (voir ProcInfo::reapZombies()) : le prochain
+    // processus qui l'aura ne doit rien heriter de l'ancien
+
+    void Scheduler::forgetProc(const int procPid) {
+        for(unsigned int kCpu = 0; kCpu < waitQueue . size(); ++kCpu) {
+            waitQueue[kCpu] . erase(remove(waitQueue[kCpu] . begin(),
+                                           waitQueue[kCpu] . end(), procPid),
+                                    waitQueue[kCpu] . end());
+        }
+        if(procPid < (int)procAffinity . size()) {
+            procAffinity[procPid] = ProcAffinity();
+        }
+    }
+
+    bool Scheduler::qIdle() const {
+        for(unsigned int kCpu = 0; kCpu < waitQueue . size(); ++kCpu) {
+            if(waitQueue[kCpu] . size()) return false;
+        }
+        return true;
+    }
+
+    Scheduler::ProcAffinity & Scheduler::affinityOf(const int procPid) {
+        if(procPid >= (int)procAffinity . size()) {
+            procAffinity . resize(procPid + 1);
+        }
+        return procAffinity[procPid];
+    }
+
     void Scheduler::enQueueProc(const int procPid) {
-        waitQueue . push_back(procPid); // par derriere
+        // dans la file du CPU qui l'a elu en dernier (affinite), sinon
+        // dans la plus courte (nouveau processus, fils d'un FORK...)
+        int cpu (affinityOf(procPid) . cpu);
+        if(cpu < 0) {
+            cpu = 0;
+            for(unsigned int kCpu = 1; kCpu < waitQueue . size(); ++kCpu) {
+                if(waitQueue[kCpu] . size() < waitQueue[cpu] . size()) {
+                    cpu = kCpu;
+                }
+            }
+        }
+        waitQueue[cpu] . push_back(procPid); // par derriere
     }
     
     void Scheduler::enQueueAllProc() {
         for(unsigned int kProc = 0; kProc < pInfo -> procData . size(); 
             ++kProc) {
-            if(pInfo -> procData [kProc] -> procStatus 
+            if(pInfo -> procData [kProc] &&
+               pInfo -> procData [kProc] -> procStatus 
                == ProcInfo::STAT_WAITING) {
                 enQueueProc(kProc);
             }
@@ -2176,42 +3511,256 @@ namespace ProcDebug {
     }
     
     void Scheduler::displayQueue(ostream *s) {
-        (*s) << "(" ;
-        for(unsigned int kProc = 0; kProc < waitQueue . size(); ++kProc) {
-            (*s) << waitQueue[kProc] ;
-            if(kProc < waitQueue . size() - 1) (*s) << ",";
+        for(unsigned int kCpu = 0; kCpu < waitQueue . size(); ++kCpu) {
+            if(waitQueue . size() > 1) (*s) << "cpu" << kCpu;
+            (*s) << "(" ;
+            for(unsigned int kProc = 0; kProc < waitQueue[kCpu] . size(); 
+                ++kProc) {
+                (*s) << waitQueue[kCpu][kProc] ;
+                if(kProc < waitQueue[kCpu] . size() - 1) (*s) << ",";
+            }
+            (*s) << ")";
         }
-        (*s) << ")\n";
+        (*s) << "\n";
+    }
+
+    // vol de travail : un CPU dont la file est vide prend, par derriere
+    // (le moins "chaud" dans le cache de l'autre), un processus de la
+    // file la plus longue, s'il n'a pas deja tourne pendant ce tick
+
+    int Scheduler::stealAProc(const int cpu) {
+        int victim (-1);
+        for(unsigned int kCpu = 0; kCpu < waitQueue . size(); ++kCpu) {
+            if((int)kCpu != cpu && waitQueue[kCpu] . size() &&
+               (victim < 0 || 
+                waitQueue[kCpu] . size() > waitQueue[victim] . size())) {
+                victim = kCpu;
+            }
+        }
+        if(victim < 0) return ProcInfo::invalidProcPid;
+        deque<int> & victimQueue (waitQueue[victim]);
+        for(int kProc = victimQueue . size() - 1; kProc >= 0; --kProc) {
+            const int candidate (victimQueue[kProc]);
+            if(affinityOf(candidate) . lastTick != tickCount) {
+                victimQueue . erase(victimQueue . begin() + kProc);
+                ++cpuStat[cpu] . steals;
+                return candidate;
+            }
+        }
+        return ProcInfo::invalidProcPid;
     }
     
-    // la fonction "principale" de l'ordonnanceur
-    
-    int Scheduler::electAProc() {
+    // le choix proprement dit, sans les statistiques
+
+    int Scheduler::pickAProc(const int cpu) {
         int chosenProc (ProcInfo::invalidProcPid);
+        deque<int> & runQueue (waitQueue[cpu]);
         // le tourniquet est la seule politique : 
         // on sort par devant (et on sait que
         // enQueueProc fait rentrer par derriere)
         int siJamais (bRand(5)); // enfin, presque...
-        if(waitQueue . size()) {
-            if(siJamais >= 4 && waitQueue . size() > 1) {
-                    chosenProc = waitQueue[1]; // il y a des jours comme ca
-                    int pasCetteFois  = waitQueue . front();
-                    waitQueue . pop_front(); // pour rentrer derriere
-                    waitQueue . pop_front(); // car c'est l'elu cette fois
-                    waitQueue . push_back(pasCetteFois); // c'est reparti
+        if(runQueue . size()) {
+            if(siJamais >= 4 && runQueue . size() > 1) {
+                    chosenProc = runQueue[1]; // il y a des jours comme ca
+                    int pasCetteFois  = runQueue . front();
+                    runQueue . pop_front(); // pour rentrer derriere
+                    runQueue . pop_front(); // car c'est l'elu cette fois
+                    runQueue . push_back(pasCetteFois); // c'est reparti
             }
             else { // comme d'hab
-                chosenProc = waitQueue . front();
-                waitQueue . pop_front();
+                chosenProc = runQueue . front();
+                runQueue . pop_front();
+            }
+        }
+        else if(waitQueue . size() > 1) {
+            chosenProc = stealAProc(cpu);
+        }
+        return chosenProc;
+    } // pickAProc()
+
+    // en rejeu, l'elu vient du journal : on le sort de sa file comme
+    // pickAProc() l'aurait fait, pour que les files restent identiques
+
+    void Scheduler::takeReplayedProc(const int cpu, const int procPid) {
+        if(procPid == ProcInfo::invalidProcPid) return;
+        deque<int> & runQueue (waitQueue[cpu]);
+        if(runQueue . size() && runQueue . front() == procPid) {
+            runQueue . pop_front();
+            return;
+        }
+        if(runQueue . size() > 1 && runQueue[1] == procPid) {
+            const int pasCetteFois (runQueue . front());
+            runQueue . pop_front();
+            runQueue . pop_front();
+            runQueue . push_back(pasCetteFois);
+            return;
+        }
+        for(unsigned int kCpu = 0; kCpu < waitQueue . size(); ++kCpu) {
+            deque<int>::iterator found (find(waitQueue[kCpu] . begin(),
+                                             waitQueue[kCpu] . end(),
+                                             procPid));
+            if(found != waitQueue[kCpu] . end()) {
+                waitQueue[kCpu] . erase(found);
+                ++cpuStat[cpu] . steals;
+                return;
+            }
+        }
+        ostringstream msg;
+        msg << "le rejeu a diverge : le processus " << procPid
+            << " n'est dans aucune file";
+        throw CExc("Scheduler::electAProc()", msg . str());
+    } // takeReplayedProc()
+
+    // la fonction "principale" de l'ordonnanceur
+    
+    int Scheduler::electAProc(const int cpu /* = 0 */) {
+        int chosenProc (ProcInfo::invalidProcPid);
+        Journal * journal (pInfo -> journal);
+        if(journal && journal -> qReplaying() &&
+           journal -> replayElection(&chosenProc)) {
+            takeReplayedProc(cpu, chosenProc);
+        }
+        else {
+            chosenProc = pickAProc(cpu);
+            if(journal && journal -> qRecording()) {
+                journal -> recordElection(chosenProc);
             }
         }
+        if(chosenProc == ProcInfo::invalidProcPid) {
+            ++cpuStat[cpu] . idleTicks;
+        }
+        else {
+            ++cpuStat[cpu] . busyTicks;
+            ProcAffinity & affinity (affinityOf(chosenProc));
+            if(affinity . cpu >= 0 && affinity . cpu != cpu) {
+                ++affinity . migrations;
+            }
+            affinity . cpu      = cpu;
+            affinity . lastTick = tickCount;
+        }
         if(qSchedulingVerbose) {
-            cerr << "Sched: elected " << chosenProc << " remaining ";
+            cerr << "Sched: ";
+            if(waitQueue . size() > 1) cerr << "cpu" << cpu << " ";
+            cerr << "elected " << chosenProc << " remaining ";
             displayQueue(&cerr);
         }
         return chosenProc;
     } // electAProc()
 
+    // statistiques : utilisation de chaque CPU et affinite des processus
+
+    void Scheduler::dumpStat(ostream *s) {
+        (*s) << "Sched: " << waitQueue . size() << " cpu(s), "
+             << tickCount - 1 << " ticks\n";
+        for(unsigned int kCpu = 0; kCpu < cpuStat . size(); ++kCpu) {
+            const unsigned long total (cpuStat[kCpu] . busyTicks +
+                                       cpuStat[kCpu] . idleTicks);
+            (*s) << "  cpu" << kCpu << " busy " << cpuStat[kCpu] . busyTicks
+                 << " idle " << cpuStat[kCpu] . idleTicks
+                 << " utilization " 
+                 << (total ? 100 * cpuStat[kCpu] . busyTicks / total : 0)
+                 << "% steals " << cpuStat[kCpu] . steals << "\n";
+        }
+        for(unsigned int kProc = 0; kProc < procAffinity . size(); ++kProc) {
+            (*s) << "  [" << kProc + 1 << "] last cpu " 
+                 << procAffinity[kProc] . cpu
+                 << " migrations " << procAffinity[kProc] . migrations 
+                 << "\n";
+        }
+    } // dumpStat()
+
+    // detection d'interblocage, appelee a chaque election par la boucle
+    // principale : deux compteurs suffisent, donc O(1)
+    //  - tous les processus vivants sont en STAT_MUTEXWAIT : personne ne
+    //    pourra plus faire le V
+    //  - ou bien aucun pas n'a change quoi que ce soit depuis assez
+    //    longtemps pour que chacun ait fait plusieurs tours de sa plus
+    //    longue boucle : ils attendent tous (LOAD d'un drapeau de la
+    //    memoire partagee, P qui echoue...) quelque chose qui ne viendra
+    //    pas, puisque plus personne n'ecrit
+
+    const unsigned int Scheduler::DEADLOCK_ROUNDS;
+
+    bool Scheduler::qAllBlocked() const {
+        if(pInfo -> outstandingProcCount <= 0) return false;
+        // une ligne tapee, ou la fin d'une requete au disque, peut
+        // encore tout debloquer
+        if(pInfo -> qInputWait() || pInfo -> device . qBusy()) return false;
+        // tous en attente du mutex, et personne ne le rendra ; s'il est
+        // libre, le prochain qui reessaie l'aura
+        const bool qBlocked ((mutexWaitCount >= pInfo -> outstandingProcCount
+                              && pInfo -> mutex == 0) ||
+                             stepsSinceProgress >
+                             static_cast<unsigned long>(DEADLOCK_ROUNDS) *
+                             (pInfo -> maxProgLength + 1) *
+                             pInfo -> outstandingProcCount);
+        // le parcours des processus, seulement quand tout dit oui
+        return qBlocked && !qSignalCanWake();
+    } // qAllBlocked()
+
+    // SIGNAL ... ENDSIGNAL puis SIGADD @ 2 : le traitant peut changer la
+    // variable que le processus attend (WHILE (attente) sans rien ecrire).
+    // un processus en attente du mutex ne tourne pas : le signal ne le
+    // reveillera pas, il ne compte pas
+
+    bool Scheduler::qSignalCanWake() const {
+        for(unsigned int kProc = 0; kProc < pInfo -> procData . size();
+            ++kProc) {
+            const ProcInfo::ProcData * pData (pInfo -> procData[kProc]);
+            if(pData == 0 || !pData -> hanDler ||
+               pData -> procStatus == ProcInfo::STAT_TERMINATED ||
+               pData -> procMutexStatus == ProcInfo::STAT_MUTEXWAIT) continue;
+            for(int sig = 1; sig < NSIG; ++sig) {
+                if(sig != SIGQUIT && sigismember(&pData -> sigMask, sig) == 1) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    } // qSignalCanWake()
+
+    // le graphe d'attente : pour chaque processus vivant, la ligne ou il
+    // est bloque et ce qu'il attend ; les pids sont affiches a partir
+    // de 1, comme partout ailleurs
+
+    void Scheduler::dumpWaitForGraph(ostream *s) {
+        const int mutexOwner (__sync_fetch_and_add(&pInfo -> mutexOwner, 0));
+        (*s) << "DEADLOCK no live process can make progress ("
+             << stepsSinceProgress << " steps without progress)\n";
+        for(unsigned int kProc = 0; kProc < pInfo -> procData . size(); 
+            ++kProc) {
+            ProcInfo::ProcData * pData (pInfo -> procData[kProc]);
+            if(pData == 0 ||
+               pData -> procStatus == ProcInfo::STAT_TERMINATED) continue;
+            ProcInfo::ProcInstruction * p (
+                pInfo -> findCrtInstruction(pData -> proGram));
+            (*s) << "  [" << kProc + 1 << "] " << pData -> progName << ":"
+                 << (p ? p -> lineNumber + 1 : 0) << " "
+                 << (p ? ProcInfo::instructionKeyword[p -> instructionType]
+                       : "?");
+            if(pData -> procMutexStatus == ProcInfo::STAT_MUTEXWAIT) {
+                (*s) << " waits for the mutex -> [" 
+                     << mutexOwner + 1 << "]";
+            }
+            else {
+                (*s) << " spins without writing anything";
+            }
+            if(mutexOwner == static_cast<int>(kProc)) {
+                (*s) << " (holds the mutex)";
+            }
+            (*s) << "\n";
+        }
+        if(mutexOwner == ProcInfo::invalidProcPid) {
+            (*s) << "  mutex is free\n";
+        }
+        else if(pInfo -> procData[mutexOwner] -> procStatus ==
+                ProcInfo::STAT_TERMINATED) {
+            (*s) << "  mutex held by [" << mutexOwner + 1 << "] "
+                 << pInfo -> procData[mutexOwner] -> progName
+                 << " which has terminated\n";
+        }
+    } // dumpWaitForGraph()
+
 } // namespace ProcDebug
 
 #undef STATUS
@@ -24,6 +24,14 @@
 
 #include "MiniDbg.h"
 #include "ProcDebug.h"
+#include "ParEngine.h"
+#include "Journal.h"
+#include "Checkpoint.h"
+#include "OutputCapture.h"
+#include "InputFeed.h"
+#include "Device.h"
+#include "DbgThread.h"
+#include "DbgServer.h"
 #include "CExc.h"
 #include "nsSysteme.h"
 
@@ -39,6 +47,20 @@ namespace
     ProcInfo * procInfo;
     int newProc2Run;
     MiniDbg * miniDbg;
+    ifstream script; // --script : les commandes du débugger
+    // --non-stop : le thread qui lit les commandes, et SIGQUIT, qui ne
+    // fait plus que demander l'arrêt au prochain tick
+    DbgThread * dbgThread;
+    volatile sig_atomic_t qArretDemande;
+    // --dbg-socket : à la place du thread lecteur, les clients de la
+    // socket ; le débugger écrit dans dbgSortie, qui part au client de la
+    // commande, ou à tous pour un arrêt venu d'ailleurs
+    DbgServer * dbgServer;
+    ostringstream dbgSortie;
+
+    // code de retour quand on s'arrete sur un interblocage,
+    // pour que les scripts de test le distinguent d'une fin normale
+    const int EXIT_DEADLOCK = 2;
 
     void LancerDbg (int n)
     {
@@ -51,18 +73,117 @@ namespace
         // (avec le processus dont l'instruction était en cours lors 
         // de la réception du signal SIGQUIT)
         if (!miniDbg)
-            miniDbg = new MiniDbg (procInfo, newProc2Run);
+            miniDbg = script.is_open()
+                ? new MiniDbg (procInfo, newProc2Run, script, true)
+                : new MiniDbg (procInfo, newProc2Run);
         else
             miniDbg -> SetProc (newProc2Run);
 
-        cout << "Interruption à la ligne "
-             << procInfo -> procData[newProc2Run] -> nextLineNumber -1
-             << '\n';
-
         miniDbg -> Prompt();
 
     } // LancerDbg()
 
+    void DemanderArret (int n)
+    {
+        qArretDemande = 1;
+
+    } // DemanderArret()
+
+    // le débugger non-stop a encore quelqu'un pour ses arrêts
+    bool DbgNonStop ()
+    {
+        return dbgThread || dbgServer;
+
+    } // DbgNonStop()
+
+    // un arrêt qui ne vient pas du débugger lui-même (watchpoint,
+    // interblocage, restore) : le prompt, ou en non-stop le seul
+    // processus concerné
+    void ArreterDbg (int Pid, const char * Raison)
+    {
+        newProc2Run = Pid;
+        if (DbgNonStop())
+            miniDbg -> Arreter (Pid, Raison);
+        else
+            LancerDbg (SIGQUIT);
+
+    } // ArreterDbg()
+
+    // tous les processus vivants sont arrêtés par le débugger
+    bool ToutArrete ()
+    {
+        for (unsigned i (0); i < procInfo -> procData.size(); ++i)
+            if (procInfo -> procData[i] &&
+                procInfo -> procData[i] -> procStatus !=
+                                            ProcInfo::STAT_TERMINATED &&
+                procInfo -> procData[i] -> procStatus !=
+                                            ProcInfo::STAT_TRACEEND)
+                return false;
+        return true;
+
+    } // ToutArrete()
+
+    // les arrêts survenus depuis le tick précédent, pour tous, puis
+    // chaque commande, dont la réponse ne va qu'à son client
+    void ServirClients (bool qAttendre)
+    {
+        dbgServer -> broadcast (dbgSortie.str());
+        dbgSortie.str ("");
+        int Client;
+        for (string Ligne; dbgServer -> takeCommand (&Ligne, &Client,
+                                                     qAttendre);
+             qAttendre = false)
+        {
+            miniDbg -> Executer (Ligne);
+            dbgServer -> reply (Client, dbgSortie.str());
+            dbgSortie.str ("");
+            if (!procInfo -> outstandingProcCount) return; // quit
+        }
+
+    } // ServirClients()
+
+    // non-stop, entre deux ticks : l'arrêt demandé par SIGQUIT, puis les
+    // commandes arrivées entre-temps ; avec qAttendre (tout est arrêté,
+    // rien ne bougera sans une commande), on attend la première
+    void ServirDbg (bool qAttendre)
+    {
+        if (qArretDemande)
+        {
+            qArretDemande = 0;
+            int Pid (newProc2Run);
+            for (unsigned i (0); Pid == ProcInfo::invalidProcPid ||
+                                 Pid >= (int)procInfo -> procData.size() ||
+                                 !procInfo -> procData[Pid] ||
+                                 procInfo -> procData[Pid] -> procStatus ==
+                                            ProcInfo::STAT_TERMINATED; ++i)
+            {
+                if (i >= procInfo -> procData.size()) return;
+                Pid = i;
+            }
+            miniDbg -> Arreter (Pid, "interrupt");
+        }
+        if (dbgServer)
+        {
+            ServirClients (qAttendre);
+            return;
+        }
+        for (string Ligne; dbgThread -> takeCommand (&Ligne, qAttendre);
+             qAttendre = false)
+        {
+            miniDbg -> Executer (Ligne);
+            if (!procInfo -> outstandingProcCount) return; // quit
+            miniDbg -> AfficherPrompt();
+        }
+        if (dbgThread -> qAtEnd())
+        {
+            cout << '\n';
+            miniDbg -> FinDesCommandes();
+            delete dbgThread;
+            dbgThread = 0; // les arrêts suivants n'ont plus personne
+        }
+
+    } // ServirDbg()
+
     void TraiterSig (int n)
     {
         int processus = (miniDbg ? miniDbg -> GetProc() : newProc2Run);
@@ -81,6 +202,7 @@ namespace
         }
         else
         {
+            procInfo -> output . flush(); // on va mourir du signal
             Signal(n, SIG_DFL);
             raise (n);
         }
@@ -94,18 +216,257 @@ int main (int argc, char *argv[])  {
         int reqVerb (0);
         const int nbVerb(5);
         int verbLevel[nbVerb];
-        if(argc != 3                     || 
-           (reqVerb = atoi(argv[2])) < 0 || 
-           reqVerb > nbVerb)
-        {
-               throw CExc ("main()", string("Usage : ") +  argv[0] + 
+        const string Usage (string("Usage : ") +  argv[0] + 
                 " <list of prog file paths>\n"
                 "                    <verboseLevel(from 0 to 5, where\n"
                 "        1 for main steps, 2 + tokens, 3 + parsing,\n"
-                "        4 + exec and 5 + sched)>\n" + 
+                "        4 + exec and 5 + sched)>\n"
+                "                    [options]\n"
+                "Options :\n"
+                "  --deadlock=stop|debug  on deadlock, print the wait-for\n"
+                "                         graph then exit (default) or\n"
+                "                         start the debugger\n"
+                "  --cpus=<n>             simulate n CPUs, each with its\n"
+                "                         own run queue (default 1)\n"
+                "  --stats                print scheduling statistics\n"
+                "                         at exit\n"
+                "  --threads=<n>          run the processes elected at\n"
+                "                         each tick on n worker threads\n"
+                "                         (implies --cpus=<n> by default)\n"
+                "  --quantum=<q>          steps run by a process on a\n"
+                "                         worker thread before the next\n"
+                "                         election (default 64)\n"
+                "  --seed=<n>             seed of the scheduler's random\n"
+                "                         choices (default: the pid)\n"
+                "  --record=<file>        log every election and every\n"
+                "                         READ value to file\n"
+                "  --replay=<file>        replay a log made by --record\n"
+                "                         (same programs, no --threads)\n"
+                "  --checkpoint=<t>:<file> save the whole simulation to\n"
+                "                         file at the start of tick t\n"
+                "  --restore=<file>       start from a checkpoint (same\n"
+                "                         programs, no --replay)\n"
+                "  --script=<file>        run the debugger from the first\n"
+                "                         instruction on the commands of\n"
+                "                         file, with machine-readable\n"
+                "                         output (@stop, @value... lines)\n"
+                "  --non-stop             SIGQUIT stops only the current\n"
+                "                         process, the others keep running\n"
+                "                         while the debugger reads commands\n"
+                "  --dbg-socket=<path>    like --non-stop, but the debugger\n"
+                "                         serves the clients of a Unix\n"
+                "                         socket instead of stdin, with\n"
+                "                         machine-readable replies ended\n"
+                "                         by @done; attach a console with\n"
+                "                         " + argv[0] + " --attach=<path>\n"
+                "  --output=<policy>      when PRINT output is written:\n"
+                "                         line (default on a terminal),\n"
+                "                         full (buffer full, default\n"
+                "                         otherwise) or unbuffered (after\n"
+                "                         every PRINT); always before a\n"
+                "                         READ, the debugger, and at exit\n"
+                "  --capture=<sink>       send each process's PRINT output\n"
+                "                         elsewhere, written by a\n"
+                "                         background thread:\n"
+                "                         files:<prefix> (one file\n"
+                "                         <prefix>.<pid> per process),\n"
+                "                         tagged:<file> (lines prefixed\n"
+                "                         by [<pid>]) or none\n"
+                "  --input=[<k>:]<source> values read by READ, for the\n"
+                "                         k-th program (and its FORKs),\n"
+                "                         or else for all: file:<file>\n"
+                "                         (its integers, then stdin),\n"
+                "                         const:<v> or\n"
+                "                         random:<min>:<max>[:<seed>]\n"
+                "  --device=<lat>:<bw>[:<words>[:<blocks>]]\n"
+                "                         the block device of DEVREAD and\n"
+                "                         DEVWRITE: latency in ticks,\n"
+                "                         bandwidth in words per tick,\n"
+                "                         words per block, blocks\n"
+                "                         (default 8:4:16:256)\n"
+                "  --undo=<n>             entries of the per-process log\n"
+                "                         used by reverse-step (default\n"
+                "                         1024, 0 to disable, else >= 64)\n"
                 "Example: " + argv[0] + " 'tst/tst1.0.m tst/tst1.1.m' 5\n");
+        // la console d'un débugger --dbg-socket, pas une simulation
+        if (argc == 2 && string (argv[1]).compare (0, 9, "--attach=") == 0)
+            return DbgServer::attach (argv[1] + 9);
+        if(argc < 3                      || 
+           (reqVerb = atoi(argv[2])) < 0 || 
+           reqVerb > nbVerb)
+        {
+               throw CExc ("main()", Usage);
         }
 
+        // options facultatives, apres le niveau de verbosite
+        bool qDeadlockDbg (false); // par defaut on s'arrete
+        int  nbCpu        (1);
+        bool qStats       (false);
+        int  nbThread     (0);   // 0 : tout sur le thread principal
+        int  quantum      (ParEngine::DEFAULT_QUANTUM);
+        bool qCpuGiven    (false);
+        unsigned int seed (::getpid());
+        bool qSeedGiven   (false);
+        string recordFile, replayFile;
+        int  undoLogSize  (ProcInfo::DEFAULT_UNDO_LOG_SIZE);
+        string checkpointFile, restoreFile;
+        unsigned long checkpointTick (0);
+        bool qNonStop     (false);
+        string dbgSocket;
+        int  outputPolicy (-1);  // -1 : selon que stdout est un terminal
+        int  captureMode  (-1);  // -1 : pas de --capture
+        string capturePath;
+        vector<pair<int, string> > inputSpecs; // (k ou 0, source)
+        unsigned int devParam[4] = { Device::DEFAULT_LATENCY,
+                                     Device::DEFAULT_BANDWIDTH,
+                                     Device::DEFAULT_BLOCK_WORDS,
+                                     Device::DEFAULT_BLOCKS };
+        for (int i (3); i < argc; ++i)
+        {
+            const string Opt (argv[i]);
+            if      (Opt == "--deadlock=stop" ) qDeadlockDbg = false;
+            else if (Opt == "--deadlock=debug") qDeadlockDbg = true;
+            else if (Opt == "--stats"         ) qStats       = true;
+            else if (Opt == "--non-stop"      ) qNonStop     = true;
+            else if (Opt.compare (0, 13, "--dbg-socket=") == 0 &&
+                     Opt.size() > 13)
+            {
+                dbgSocket = Opt.substr (13);
+                qNonStop  = true;
+            }
+            else if (Opt == "--output=line"   )
+                outputPolicy = PrintBuffer::FLUSH_LINE;
+            else if (Opt == "--output=full"   )
+                outputPolicy = PrintBuffer::FLUSH_FULL;
+            else if (Opt == "--output=unbuffered")
+                outputPolicy = PrintBuffer::FLUSH_ALWAYS;
+            else if (Opt == "--capture=none"  )
+                captureMode = OutputCapture::CAPTURE_NONE;
+            else if (Opt.compare (0, 16, "--capture=files:") == 0 &&
+                     Opt.size() > 16)
+            {
+                captureMode = OutputCapture::CAPTURE_FILES;
+                capturePath = Opt.substr (16);
+            }
+            else if (Opt.compare (0, 17, "--capture=tagged:") == 0 &&
+                     Opt.size() > 17)
+            {
+                captureMode = OutputCapture::CAPTURE_TAGGED;
+                capturePath = Opt.substr (17);
+            }
+            else if (Opt.compare (0, 8, "--input=") == 0)
+            {
+                // <k>: devant la source, sinon pour tous
+                char * End;
+                const long Prog (strtol (Opt.c_str() + 8, &End, 10));
+                if (*End == ':' && End != Opt.c_str() + 8)
+                {
+                    if (Prog < 1)
+                        throw CExc ("main()", "Programme invalide " + Opt
+                                              + "\n");
+                    inputSpecs.push_back (make_pair ((int) Prog,
+                                                     string (End + 1)));
+                }
+                else
+                    inputSpecs.push_back (make_pair (0, Opt.substr (8)));
+            }
+            else if (Opt.compare (0, 9, "--device=") == 0)
+            {
+                // au moins la latence et le débit, tous > 0 sauf la
+                // latence
+                const char * Crt (Opt.c_str() + 9);
+                unsigned Field (0);
+                for (char * End; Field < 4; ++Field, Crt = End + 1)
+                {
+                    const long Val (strtol (Crt, &End, 10));
+                    if (End == Crt || Val < (Field ? 1 : 0) || Val > 1 << 20)
+                        throw CExc ("main()", "Peripherique invalide " + Opt
+                                              + "\n");
+                    devParam[Field] = Val;
+                    if (*End != ':') { ++Field; Crt = End; break; }
+                }
+                if (*Crt || Field < 2)
+                    throw CExc ("main()", "Peripherique invalide " + Opt
+                                          + "\n");
+            }
+            else if (Opt.compare (0, 7, "--cpus=") == 0)
+            {
+                if ((nbCpu = atoi (Opt.c_str() + 7)) < 1)
+                    throw CExc ("main()", "Nombre de CPUs invalide " + Opt
+                                          + "\n");
+                qCpuGiven = true;
+            }
+            else if (Opt.compare (0, 10, "--threads=") == 0)
+            {
+                if ((nbThread = atoi (Opt.c_str() + 10)) < 1)
+                    throw CExc ("main()", "Nombre de threads invalide "
+                                          + Opt + "\n");
+            }
+            else if (Opt.compare (0, 7, "--seed=") == 0)
+            {
+                char * End;
+                seed = strtoul (Opt.c_str() + 7, &End, 10);
+                if (*End || End == Opt.c_str() + 7)
+                    throw CExc ("main()", "Graine invalide " + Opt + "\n");
+                qSeedGiven = true;
+            }
+            else if (Opt.compare (0, 9, "--record=") == 0)
+                recordFile = Opt.substr (9);
+            else if (Opt.compare (0, 9, "--replay=") == 0)
+                replayFile = Opt.substr (9);
+            else if (Opt.compare (0, 13, "--checkpoint=") == 0)
+            {
+                char * End;
+                checkpointTick = strtoul (Opt.c_str() + 13, &End, 10);
+                if (*End != ':' || End == Opt.c_str() + 13 || !End[1])
+                    throw CExc ("main()", "Checkpoint invalide " + Opt
+                                          + "\n");
+                checkpointFile = End + 1;
+            }
+            else if (Opt.compare (0, 10, "--restore=") == 0)
+                restoreFile = Opt.substr (10);
+            else if (Opt.compare (0, 9, "--script=") == 0)
+            {
+                script.open (Opt.c_str() + 9);
+                if (!script)
+                    throw CExc ("main()", "Script illisible " + Opt + "\n");
+            }
+            else if (Opt.compare (0, 7, "--undo=") == 0)
+            {
+                // un pas journalise tient en quelques entrees par
+                // niveau d'imbrication : en dessous de 64, l'anneau
+                // risquerait de ne pas en contenir un seul
+                undoLogSize = atoi (Opt.c_str() + 7);
+                if (undoLogSize < 0 || (undoLogSize && undoLogSize < 64))
+                    throw CExc ("main()", "Taille de journal invalide "
+                                          + Opt + "\n");
+            }
+            else if (Opt.compare (0, 10, "--quantum=") == 0)
+            {
+                if ((quantum = atoi (Opt.c_str() + 10)) < 1)
+                    throw CExc ("main()", "Quantum invalide " + Opt + "\n");
+            }
+            else throw CExc ("main()", "Option inconnue " + Opt + "\n"
+                                       + Usage);
+        }
+        if (nbThread && !qCpuGiven) nbCpu = nbThread;
+        // en parallele, l'entrelacement dans un quantum ne depend pas
+        // que des elections : le journal ne suffirait pas a le rejouer
+        if (nbThread && (recordFile.size() || replayFile.size()))
+            throw CExc ("main()", "--record et --replay sont "
+                                  "incompatibles avec --threads\n");
+        if (recordFile.size() && replayFile.size())
+            throw CExc ("main()", "--record ou --replay, pas les deux\n");
+        // le journal rejoue depuis le debut, pas depuis un checkpoint :
+        // un journal commence apres un restore ne se rejouerait pas
+        if (restoreFile.size() && (recordFile.size() || replayFile.size()))
+            throw CExc ("main()", "--restore est incompatible avec "
+                                  "--record et --replay\n");
+        // un script attend chaque arrêt avant sa commande suivante
+        if (qNonStop && script.is_open())
+            throw CExc ("main()", "--script et --non-stop sont "
+                                  "incompatibles\n");
+
         int k (0);
         for(; k < reqVerb; ++k)
         {
@@ -119,9 +480,71 @@ int main (int argc, char *argv[])  {
         procInfo = new ProcInfo(argv[1],
                         verbLevel[0],verbLevel[1],
                         verbLevel[2],verbLevel[3]);
+        Journal * journal (0);
+        if (replayFile.size())
+        {
+            journal = new Journal (replayFile, Journal::JOURNAL_REPLAY);
+            if (!qSeedGiven) seed = journal -> getSeed();
+        }
+        else if (recordFile.size())
+            journal = new Journal (recordFile, Journal::JOURNAL_RECORD, seed);
+        procInfo -> journal = journal;
+        // l'instant où arrive une ligne ne se rejoue pas ; en non-stop
+        // sur la console, l'entrée standard est au débugger, sur socket
+        // elle est aux READ, sans bloquer le service des clients
+        procInfo -> qAsyncRead = !journal && (!qNonStop || dbgSocket.size());
+        if (dbgSocket.size())
+            procInfo -> inputIdleWait = ProcInfo::DBG_INPUT_WAIT;
+        procInfo -> undoLogSize = undoLogSize;
+        procInfo -> device . configure (devParam[0], devParam[1],
+                                        devParam[2], devParam[3]);
+        if (outputPolicy >= 0)
+            procInfo -> output . setPolicy (
+                              (PrintBuffer::FlushPolicy) outputPolicy);
+        OutputCapture * capture (captureMode < 0 ? 0 :
+            new OutputCapture ((OutputCapture::CaptureMode) captureMode,
+                               capturePath));
+        procInfo -> capture = capture;
+        InputFeeds * input (inputSpecs.empty() ? 0 : new InputFeeds);
+        procInfo -> input = input;
+        for (unsigned i (0); i < inputSpecs.size(); ++i)
+        {
+            const int Prog (inputSpecs[i].first);
+            if (Prog > (int) procInfo -> procData.size())
+            {
+                ostringstream Msg;
+                Msg << "--input : pas de programme numero " << Prog << '\n';
+                throw CExc ("main()", Msg.str());
+            }
+            input -> add (Prog ? procInfo -> procData[Prog - 1] -> progName
+                               : string(),
+                          new InputFeed (inputSpecs[i].second, seed));
+        }
+        // en non-stop sur la console, le débugger lit l'entrée standard
+        // dans son propre thread : un READ qui la lirait aussi lui
+        // prendrait des commandes, ou le débugger ses lignes
+        if (qNonStop && dbgSocket.empty())
+            for (unsigned i (0); i < procInfo -> procData.size(); ++i)
+                if (procInfo -> qReadsStdin (i))
+                    throw CExc ("main()", procInfo -> procData[i] -> progName
+                                + " lit l'entrée standard : --non-stop "
+                                  "demande alors --input=const: ou "
+                                  "random:, ou --dbg-socket=\n");
+        ::srand (seed); // apres le constructeur, qui prend le pid
+
         Scheduler scheduler(procInfo,verbLevel[4]);
         procInfo -> scheduler = &scheduler;
+        scheduler . setCpuCount (nbCpu);
         scheduler . enQueueAllProc();
+        if (restoreFile.size())
+        {
+            Checkpoint::restore (procInfo, restoreFile);
+            nbCpu = scheduler . getCpuCount(); // celui du checkpoint
+        }
+        ParEngine * parEngine (nbThread ? new ParEngine (procInfo, nbThread,
+                                                        quantum)
+                                        : 0);
+        vector<int> electedProcs;
         if(verbLevel[1])
         {
             cerr << "Starting up...";
@@ -151,28 +574,187 @@ int main (int argc, char *argv[])  {
 */
 
         DerouterSignaux (TraiterSig); // pour SIGNAL
-        Signal (SIGQUIT, LancerDbg);  // Déroutement de SIGQUIT vers LancerDbg
+        // Déroutement de SIGQUIT vers LancerDbg, ou en non-stop une simple
+        // demande, servie entre deux ticks
+        Signal (SIGQUIT, qNonStop ? DemanderArret : LancerDbg);
+
+        // a enlever pour la release ; en mode script, personne ne
+        // regarde : pas de pause
+        procInfo -> qDoSleepAfterEachInstruction = !script.is_open();
 
-        // a enlever pour la release
-        procInfo -> qDoSleepAfterEachInstruction = true;
+        // mode script : le débugger prend la main avant la première
+        // instruction, sur le premier programme (s'il en reste un après
+        // les erreurs de syntaxe)
+        if (script.is_open() && procInfo -> outstandingProcCount)
+        {
+            newProc2Run = 0;
+            LancerDbg (SIGQUIT);
+        }
+        // non-stop : le débugger est là dès le début, sans rien arrêter
+        if (qNonStop && dbgSocket.size())
+        {
+            miniDbg   = new MiniDbg (procInfo, 0, cin, true, true);
+            miniDbg -> Rediriger (dbgSortie.rdbuf());
+            dbgServer = new DbgServer (dbgSocket);
+        }
+        else if (qNonStop)
+        {
+            miniDbg   = new MiniDbg (procInfo, 0, cin, false, true);
+            dbgThread = new DbgThread (cin);
+            miniDbg -> AfficherPrompt();
+        }
+        unsigned long nbParques (0); // élus de suite arrêtés par le débugger
 
+        // À chaque tick, chaque CPU simulé élit un processus dans sa file
+        // (avec un seul CPU, un tick = une élection, comme avant)
+        int ExitCode (0);
         while(procInfo -> outstandingProcCount)
         {
-            newProc2Run = scheduler . electAProc();
-            if(newProc2Run == ProcInfo::invalidProcPid) continue;
+            // les fils termines au tick precedent libèrent leur pid
+            procInfo -> reapZombies (miniDbg ? miniDbg -> GetProc()
+                                             : ProcInfo::invalidProcPid,
+                                     newProc2Run);
+            if (checkpointFile.size() &&
+                scheduler . getTick() == checkpointTick)
+            {
+                Checkpoint::save (*procInfo, checkpointFile);
+                cerr << "CHECKPOINT tick " << checkpointTick << " -> "
+                     << checkpointFile << "\n";
+            }
+            // READ asynchrone : les lignes arrivées réveillent ceux qui
+            // les attendent ; si personne d'autre ne peut tourner, on
+            // attend la prochaine (sauf si le disque a une requête en
+            // cours : sa fin, au tick voulu, réveillera quelqu'un)
+            procInfo -> completeDeviceIo();
+            if (procInfo -> ioWaitPids.size())
+                procInfo -> pollInput (scheduler . qIdle() &&
+                                       ! procInfo -> device . qBusy());
+            if (DbgNonStop())
+            {
+                ServirDbg (nbParques >= (unsigned long)
+                               procInfo -> outstandingProcCount &&
+                           ToutArrete());
+            }
+            // un restore demandé depuis le débugger : ici, aucun
+            // processus n'est à moitié élu
+            string restoreNow;
+            if (miniDbg && miniDbg -> PrendreRestore (&restoreNow))
+            {
+                try
+                {
+                    Checkpoint::restore (procInfo, restoreNow);
+                    nbCpu = scheduler . getCpuCount();
+                }
+                catch (const CExc & Exc)
+                {
+                    // l'etat courant est intact ; le client du socket
+                    // doit le savoir aussi
+                    ostringstream Msg;
+                    Msg << Exc;
+                    miniDbg -> SignalerErreur (Msg.str());
+                }
+                newProc2Run = miniDbg -> GetProc();
+                if (newProc2Run >= (int)procInfo -> procData . size() ||
+                    !procInfo -> procData[newProc2Run])
+                    newProc2Run = 0; // un programme charge, toujours la
+                ArreterDbg (newProc2Run, "restore");
+                // un nouveau restore : le faire avant que le processus
+                // toujours tracé n'avance d'un pas
+                continue;
+            }
+            electedProcs . clear();
+            for (int Cpu (0); Cpu < nbCpu &&
+                              procInfo -> outstandingProcCount; ++Cpu)
+            {
+                newProc2Run = scheduler . electAProc (Cpu);
+                if(newProc2Run == ProcInfo::invalidProcPid) continue;
 
-            procInfo -> avancerDUnPas(newProc2Run); // voir dans ProcDebug.cxx
+                // arrêté par le débugger (non-stop) : il garde sa place
+                // dans sa file, sans avancer
+                if (procInfo -> procData[newProc2Run] -> procStatus ==
+                                                ProcInfo::STAT_TRACEEND)
+                {
+                    procInfo -> updateProcData (newProc2Run,
+                                                ProcInfo::ADVANCE_PROC);
+                    ++nbParques;
+                    continue;
+                }
+                nbParques = 0;
+
+                // Plus personne ne peut avancer : on le dit, graphe
+                // d'attente à l'appui, au lieu de tourner indéfiniment
+                if (scheduler . qAllBlocked())
+                {
+                    procInfo -> output . flush();
+                    scheduler . dumpWaitForGraph (&cerr);
+                    // (un script épuisé ne débloquera rien non plus)
+                    if (!qDeadlockDbg || (qNonStop && !DbgNonStop()) ||
+                        (script.is_open() && script.eof()))
+                    {
+                        // la fin normale, trace et débugger compris
+                        ExitCode = EXIT_DEADLOCK;
+                        break;
+                    }
+                    if (DbgNonStop()) // tous : aucun ne peut avancer
+                        miniDbg -> ArreterTout (newProc2Run, "deadlock");
+                    else
+                        LancerDbg (SIGQUIT); // comme si on avait reçu
+                                             // le signal
+                    scheduler . noteProgress(); // on repart pour un tour
+                }
+
+                // avec des watchpoints, pas a pas : l'ecriture surveillee
+                // doit arreter le processus juste apres l'instruction
+                // (de même pour celui que le débugger non-stop a relancé,
+                // dont on teste les breakpoints)
+                if (parEngine && ! procInfo -> watchCount &&
+                    (!DbgNonStop() || newProc2Run != miniDbg -> GetSuivi()))
+                    electedProcs . push_back (newProc2Run);
+                else
+                    procInfo -> avancerDUnPas(newProc2Run); // voir ProcDebug.cxx
+
+                if (procInfo -> watchHit . procPid != ProcInfo::invalidProcPid)
+                {
+                    // comme un breakpoint
+                    ArreterDbg (procInfo -> watchHit . procPid, "watchpoint");
+                }
+                else if (DbgNonStop())
+                    miniDbg -> VerifierBreak (newProc2Run);
+            }
+            if (ExitCode) break;
+            // les elus du tick avancent ensemble, un quantum chacun
+            if (parEngine) parEngine -> runTick (electedProcs);
+            scheduler . nextTick();
         }
 
+        // ce que tdump n'a pas encore affiché, après les derniers PRINT
+        if (procInfo -> qTraceLeft())
+        {
+            procInfo -> output . flush();
+            procInfo -> dumpTrace (&cerr, false);
+        }
+        if (qStats) procInfo -> dumpProcInfoStat (&cerr);
+
+        delete parEngine;
+        delete journal;
+        delete capture; // attend que tout soit écrit
+        delete input;
         delete procInfo;
         if (miniDbg)
             delete miniDbg;
+        delete dbgThread;
+        if (dbgServer) // les derniers messages, puis on attend qu'ils
+        {              // soient partis
+            dbgServer -> broadcast (dbgSortie.str());
+            delete dbgServer;
+        }
 
-        return 0;
+        return ExitCode;
 
     } // try
 
     catch (const CExc & Exc) {
+        if (procInfo) procInfo -> output . flush();
         cerr << Exc << endl;
         return errno;
     }
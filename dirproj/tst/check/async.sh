@@ -0,0 +1,8 @@
+# READ asynchrone : tant que la ligne n'est pas tapee, les autres
+# processus tournent (compte.m finit avant la premiere valeur) et ce
+# n'est pas un interblocage ; a la fin de l'entree, le lecteur s'arrete
+(sleep 1; printf '1\n2\n3\n') |
+$PROJ 'tst/check/lecture.m tst/check/compte.m' 0 --seed=1 --script=/dev/null
+echo "exit $?"
+(sleep 1; printf '7\n') |
+$PROJ 'tst/check/lecture.m tst/check/compte.m' 0 --seed=1 --script=/dev/null
@@ -0,0 +1,16 @@
+break 4
+break 5
+break 4
+break 0
+show break
+continue
+print i
+continue
+continue
+remove break 1
+continue
+print somme
+break 6
+show break
+continue
+continue
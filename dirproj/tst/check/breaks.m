@@ -0,0 +1,9 @@
+PROGRAM
+NEW @ i : 0
+NEW @ somme : 0
+WHILE @ 1 (i < 3) REPEAT
+  COMPUTE @ somme : somme + i
+  COMPUTE @ i : i + 1
+ENDWHILE @ 1
+PRINT @ "somme ",somme,"\n"
+ENDPROGRAM
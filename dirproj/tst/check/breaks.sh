@@ -0,0 +1,3 @@
+# plusieurs breakpoints actifs dans la meme boucle : chaque continue
+# s'arrete au suivant ; une ligne sans instruction prend la suivante
+$PROJ tst/check/breaks.m 0 --script=tst/check/breaks.cmd
@@ -0,0 +1,9 @@
+PROGRAM
+NEW @ a : 17
+NEW @ b : 5
+NEW @ zero : 0
+NEW @ v : 0
+STORE @ v$0 : a
+STORE @ v$1 : b
+STORE @ _$4 : b
+ENDPROGRAM
@@ -0,0 +1,14 @@
+# --capture : les PRINT de chaque processus (fils compris), ecrits par
+# le thread d'ecriture dans un fichier par pid, ou dans un seul avec le
+# pid en tete de ligne, ou nulle part ; rien sur la sortie standard
+progs='tst/check/famille.m tst/check/compte.m'
+prefixe=tst/check/capture.tmp
+$PROJ "$progs" 0 --seed=1 --capture=files:$prefixe --script=/dev/null
+echo "exit $?"
+for f in $prefixe.*; do echo "$f :"; cat $f; done
+rm -f $prefixe.*
+$PROJ "$progs" 0 --seed=1 --capture=tagged:$prefixe --script=/dev/null
+echo "exit $?"
+cat $prefixe
+rm -f $prefixe
+$PROJ "$progs" 0 --seed=1 --capture=none --script=/dev/null
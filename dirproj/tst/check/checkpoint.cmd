@@ -0,0 +1,13 @@
+break 6 if n == 3
+continue
+checkpoint tst/check/session.ckpt
+remove break 1
+step 4
+print n
+x _$0..2
+restore tst/check/session.ckpt
+print n
+x _$0..2
+restore tst/check/inexistant.ckpt
+show proc
+continue
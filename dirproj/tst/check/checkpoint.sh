@@ -0,0 +1,18 @@
+# checkpoint et restore de toute la simulation (pere et fils, memoire
+# partagee) : depuis le debugger, puis par les options ; un fichier
+# absent laisse l'etat intact, et --record refuse tout restore
+ckpt=tst/check/options.ckpt
+$PROJ tst/check/famille.m 0 --seed=1 --script=tst/check/checkpoint.cmd
+echo "exit $?"
+$PROJ tst/check/famille.m 0 --seed=1 --checkpoint=12:$ckpt --script=/dev/null
+echo "exit $?"
+$PROJ tst/check/famille.m 0 --seed=1 --restore=$ckpt --script=/dev/null
+echo "exit $?"
+$PROJ tst/check/famille.m 0 --restore=$ckpt --record=$ckpt.journal \
+      --script=/dev/null
+echo "exit $?"
+echo "restore tst/check/session.ckpt" |
+$PROJ tst/check/famille.m 0 --record=$ckpt.journal --script=/dev/stdin
+status=$?
+rm -f $ckpt $ckpt.journal tst/check/session.ckpt
+exit $status
@@ -0,0 +1,9 @@
+PROGRAM
+NEW @ i : 0
+NEW @ somme : 0
+WHILE @ 1 (i < 20) REPEAT
+  COMPUTE @ i : i + 1
+  COMPUTE @ somme : somme + i
+ENDWHILE @ 1
+PRINT @ "somme ",somme,"\n"
+ENDPROGRAM
@@ -0,0 +1,15 @@
+break 5 if i == 2
+break 6 if i +
+break 6 if inconnue > 0
+show break
+continue
+print i
+x t$0..2
+remove break 1
+break 7 if 12 / reste
+continue
+print reste
+continue
+continue
+print reste
+continue
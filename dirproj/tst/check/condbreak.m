@@ -0,0 +1,11 @@
+PROGRAM
+NEW @ i : 0
+NEW @ reste : 4
+NEW @ t : 0
+WHILE @ 1 (i < 6) REPEAT
+  STORE @ t$i : reste
+  COMPUTE @ reste : reste - 1
+  COMPUTE @ i : i + 1
+ENDWHILE @ 1
+PRINT @ "i ",i," reste ",reste,"\n"
+ENDPROGRAM
@@ -0,0 +1,5 @@
+# breakpoints conditionnels : la condition est compilee une fois (une
+# erreur de syntaxe ou un nom inconnu sont refuses tout de suite), et
+# une condition qui ne peut pas etre evaluee arrete le processus avec
+# sa propre raison
+$PROJ tst/check/condbreak.m 0 --script=tst/check/condbreak.cmd
@@ -0,0 +1,4 @@
+# trois processus sur deux CPUs, chacun sa file : les statistiques de
+# l'ordonnanceur (occupation, vols, migrations)
+$PROJ 'tst/check/compte.m tst/check/compte.m tst/check/compte.m' 0 \
+      --cpus=2 --stats --seed=1 --script=/dev/null
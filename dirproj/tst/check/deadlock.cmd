@@ -0,0 +1,2 @@
+end
+print pid
@@ -0,0 +1,11 @@
+# interblocage : le graphe d'attente (pids a partir de 1), puis le code
+# de retour 2 ; avec --deadlock=debug, le script reprend la main, et
+# une fois epuise la simulation s'arrete comme sans debugger
+$PROJ tst/tstDeadlock.m 0 --seed=1 --script=/dev/null
+echo "exit $?"
+$PROJ tst/tstDeadlock.m 0 --seed=1 --deadlock=debug \
+      --script=tst/check/deadlock.cmd
+echo "exit $?"
+# le fils a un traitant et un signal dans son masque, mais il attend le
+# mutex : il ne tourne pas, le signal ne le debloquera pas
+$PROJ tst/check/sigmutex.m 0 --seed=1 --script=/dev/null
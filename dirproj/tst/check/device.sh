@@ -0,0 +1,8 @@
+# le peripherique de DEVREAD/DEVWRITE : 6 blocs ecrits puis relus ; seul,
+# le processus attend chaque requete (cpu inoccupe), avec compte.m les
+# attentes se recouvrent ; un bloc hors du disque est une erreur
+$PROJ tst/check/disque.m 0 --seed=1 --device=4:2:4:8 --stats \
+      --script=/dev/null
+echo "exit $?"
+$PROJ 'tst/check/disque.m tst/check/compte.m' 0 --seed=1 \
+      --device=4:2:4:8 --stats --script=/dev/null
@@ -0,0 +1,12 @@
+display n
+display somme / n
+display notes$n
+display absente
+break 12
+continue
+continue
+show display
+remove display 2
+remove display 7
+continue
+print somme
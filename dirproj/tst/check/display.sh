@@ -0,0 +1,3 @@
+# display : les expressions, resolues une fois, sont reevaluees a chaque
+# arret ; celle qui divise par n = 0 le dit sans gener les autres
+$PROJ tst/check/moyenne.m 0 --script=tst/check/display.cmd
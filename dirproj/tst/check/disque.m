@@ -0,0 +1,22 @@
+PROGRAM
+NEW @ tampon : 0
+NEW @ b : 0
+NEW @ somme : 0
+NEW @ v : 0
+WHILE @ 1 (b < 6) REPEAT
+  STORE @ tampon$0 : b
+  STORE @ tampon$3 : b
+  DEVWRITE @ tampon : b
+  COMPUTE @ b : b + 1
+ENDWHILE @ 1
+STORE @ tampon$3 : v
+WHILE @ 2 (b > 0) REPEAT
+  COMPUTE @ b : b - 1
+  DEVREAD @ tampon : b
+  LOAD @ v : tampon$3
+  COMPUTE @ somme : somme + v
+ENDWHILE @ 2
+PRINT @ "relu ",somme,"\n"
+DEVREAD @ tampon : 8
+PRINT @ "jamais\n"
+ENDPROGRAM
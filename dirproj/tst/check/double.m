@@ -0,0 +1,10 @@
+PROGRAM
+NEW @ v : 0
+NEW @ n : 2
+WHILE @ 1 (n) REPEAT
+  READ @ v
+  COMPUTE @ v : v * 2
+  PRINT @ "double ",v,"\n"
+  COMPUTE @ n : n - 1
+ENDWHILE @ 1
+ENDPROGRAM
@@ -0,0 +1,11 @@
+PROGRAM
+NEW @ k : 3
+NEW @ q : 0
+WHILE @ 1 (k > 0) REPEAT
+  PRINT @ "k ",k,"\n"
+  COMPUTE @ k : k - 1
+ENDWHILE @ 1
+PRINT @ "sans fin de ligne "
+COMPUTE @ q : 12 / k
+PRINT @ "q ",q,"\n"
+ENDPROGRAM
@@ -0,0 +1,35 @@
+break 7
+continue
+print a
+print 42
+print -3
+print a + b
+print a - -3
+print a * b
+print a / b
+print a % b
+print a > b
+print a <= b
+print a == 17
+print a != 17
+print v$1
+print v$b - 4
+print v$0 + v$1
+print _$4 * a
+print a / zero
+print a % zero
+print v$99999
+print a b
+print a + b + 1
+print a +
+print a = b
+print inconnue + 1
+print _x$1
+print a * -3
+print a == -3
+print a1
+print a.b
+print (a)
+print a \ b
+print _ $ 4 - a
+continue
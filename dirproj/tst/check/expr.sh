@@ -0,0 +1,4 @@
+# print d'expressions : constantes, variables, cases du tas (indice
+# constant ou variable) et de la memoire partagee, tous les operateurs,
+# et les erreurs de compilation ou de calcul
+$PROJ tst/check/calcul.m 0 --script=tst/check/expr.cmd
@@ -0,0 +1,10 @@
+PROGRAM
+NEW @ pid : 1
+NEW @ n : 0
+FORK @ pid
+WHILE @ 1 (n < 5) REPEAT
+  COMPUTE @ n : n + 1
+  STORE @ _$pid : n
+ENDWHILE @ 1
+PRINT @ "pid ",pid," n ",n,"\n"
+ENDPROGRAM
@@ -0,0 +1,15 @@
+PROGRAM
+NEW @ a : 0
+NEW @ b : 1
+NEW @ s : 0
+NEW @ k : 0
+NEW @ f : 0
+WHILE @ 1 (k < 40) REPEAT
+  STORE @ f$k : a
+  COMPUTE @ s : a + b
+  COPY @ a : b
+  COPY @ b : s
+  COMPUTE @ k : k + 1
+ENDWHILE @ 1
+PRINT @ "fibo ",a,"\n"
+ENDPROGRAM
@@ -0,0 +1,14 @@
+PROGRAM
+NEW @ i : 0
+NEW @ j : 0
+NEW @ total : 0
+WHILE @ 1 (i < 3) REPEAT
+  COPY @ j : 0
+  WHILE @ 2 (j < 4) REPEAT
+    COMPUTE @ total : total + j
+    COMPUTE @ j : j + 1
+  ENDWHILE @ 2
+  COMPUTE @ i : i + 1
+ENDWHILE @ 1
+PRINT @ "total ",total,"\n"
+ENDPROGRAM
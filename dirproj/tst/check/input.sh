@@ -0,0 +1,15 @@
+# --input : une constante, des valeurs au hasard (graine fixee), un
+# fichier puis l'entree standard, et une source par programme ; deux
+# sources pour le meme programme sont refusees
+progs='tst/check/lecture.m tst/check/double.m'
+for source in const:7 random:1:6:42 file:tst/check/valeurs.txt; do
+    echo "--input=$source"
+    printf '4\n5\n6\n' |
+    $PROJ "$progs" 0 --seed=1 --input=$source --script=/dev/null
+    echo "exit $?"
+done
+echo "--input=2:const:-3"
+printf '4\n5\n6\n' |
+$PROJ "$progs" 0 --seed=1 --input=2:const:-3 --script=/dev/null
+echo "exit $?"
+$PROJ "$progs" 0 --input=1:const:1 --input=1:const:2 --script=/dev/null
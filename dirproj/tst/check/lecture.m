@@ -0,0 +1,12 @@
+PROGRAM
+NEW @ n : 3
+NEW @ v : 0
+NEW @ somme : 0
+WHILE @ 1 (n) REPEAT
+  COMPUTE @ n : n - 1
+  READ @ v
+  COMPUTE @ somme : somme + v
+  PRINT @ "lu ",v,"\n"
+ENDWHILE @ 1
+PRINT @ "somme ",somme,"\n"
+ENDPROGRAM
@@ -0,0 +1,11 @@
+list
+break 8
+list
+step 6
+list 5 4
+list
+list 12
+list 40
+list 0
+list 3 x
+continue
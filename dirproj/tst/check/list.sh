@@ -0,0 +1,3 @@
+# list, sur la table des lignes faite au chargement : ligne courante
+# (=>), breakpoints (*), suite d'un list a l'autre, et bornes
+$PROJ tst/check/imbrique.m 0 --script=tst/check/list.cmd
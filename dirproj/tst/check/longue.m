@@ -0,0 +1,6 @@
+PROGRAM
+NEW @ i : 0
+WHILE @ 1 (i < 70000) REPEAT
+  COMPUTE @ i : i + 1
+ENDWHILE @ 1
+ENDPROGRAM
@@ -0,0 +1,16 @@
+PROGRAM
+NEW @ n : 0
+NEW @ somme : 0
+NEW @ moyenne : 0
+NEW @ notes : 0
+STORE @ notes$0 : 12
+STORE @ notes$1 : 8
+STORE @ notes$2 : 15
+WHILE @ 1 (n < 3) REPEAT
+  LOAD @ moyenne : notes$n
+  COMPUTE @ somme : somme + moyenne
+  COMPUTE @ n : n + 1
+  COMPUTE @ moyenne : somme / n
+ENDWHILE @ 1
+PRINT @ "moyenne ",moyenne,"\n"
+ENDPROGRAM
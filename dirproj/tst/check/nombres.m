@@ -0,0 +1,23 @@
+PROGRAM
+NEW @ zero : 0
+NEW @ petit : 0
+COMPUTE @ petit : 0 - 7
+NEW @ grand : 2147483647
+NEW @ min : 0
+NEW @ t : 0
+COMPUTE @ min : 0 - grand
+COMPUTE @ min : min - 1
+PRINT @ "zero ",zero," petit ",petit,"\n"
+PRINT @ "grand ",grand," min ",min,"\n"
+PRINT @ zero,petit,grand,"\n"
+PRINT @ "\ttab \\ \"cite\" ",grand,"\n"
+PRINT @ "nombre seul : "
+PRINT @ 1234567890
+PRINT @ "\n"
+COMPUTE @ t : 0 - 3
+WHILE @ 1 (t < 4) REPEAT
+  PRINT @ "[",t,"]"
+  COMPUTE @ t : t + 1
+ENDWHILE @ 1
+PRINT @ "\n"
+ENDPROGRAM
@@ -0,0 +1,8 @@
+# --output : quand partent les PRINT, vu de l'ordre avec le message
+# d'erreur (sorties confondues) ; line attend la fin de ligne, full
+# la fin du programme, unbuffered rien
+for policy in line full unbuffered; do
+    echo "--output=$policy"
+    $PROJ tst/check/erreur.m 0 --output=$policy --script=/dev/null 2>&1
+    echo
+done
@@ -0,0 +1,16 @@
+PROGRAM
+NEW @ i : 0
+NEW @ total : 0
+WHILE @ 1 (i < 50) REPEAT
+  MUTEX @ _ : _P
+  LOAD @ total : _$1
+  COMPUTE @ total : total + 1
+  STORE @ _$1 : total
+  MUTEX @ _ : _V
+  COMPUTE @ i : i + 1
+ENDWHILE @ 1
+WHILE @ 2 (total < 150) REPEAT
+  LOAD @ total : _$1
+ENDWHILE @ 2
+PRINT @ "total ",total,"\n"
+ENDPROGRAM
@@ -0,0 +1,3 @@
+# PRINT : les entiers (zero, negatifs, bornes de l'int), les sequences
+# d'echappement, et le meme PRINT refait dans une boucle
+$PROJ tst/check/nombres.m 0 --script=/dev/null
@@ -0,0 +1,8 @@
+# 3000 FORK de suite, chaque fils se termine aussitot : les pids liberes
+# sont repris, la table reste petite (--stats), et chacun dit "fini"
+sortie=/tmp/reap.$$
+$PROJ tst/tstForkLoop.m 0 --stats --seed=1 --script=/dev/null > $sortie
+status=$?
+uniq -c $sortie
+rm -f $sortie
+exit $status
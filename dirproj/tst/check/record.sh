@@ -0,0 +1,17 @@
+# --record note les elections et les valeurs lues ; --replay, avec une
+# autre graine et sans entree, doit refaire exactement la meme sortie,
+# fin de l'entree comprise
+progs='tst/check/lecture.m tst/check/compte.m tst/check/lecture.m'
+journal=/tmp/record.$$
+printf '1\n2\n3\n4\n5\n6\n' |
+$PROJ "$progs" 0 --seed=3 --record=$journal --script=/dev/null
+echo "exit $?"
+$PROJ "$progs" 0 --seed=4 --replay=$journal --script=/dev/null < /dev/null
+echo "exit $?"
+printf '1\n2\n3\n4\n' |
+$PROJ "$progs" 0 --seed=3 --record=$journal --script=/dev/null
+echo "exit $?"
+$PROJ "$progs" 0 --seed=4 --replay=$journal --script=/dev/null < /dev/null
+status=$?
+rm -f $journal
+exit $status
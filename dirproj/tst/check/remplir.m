@@ -0,0 +1,15 @@
+PROGRAM
+NEW @ bloc : 0
+NEW @ k : 0
+NEW @ lettre : 72
+WHILE @ 1 (k < 8) REPEAT
+  STORE @ bloc$k : 255
+  COMPUTE @ k : k + 1
+ENDWHILE @ 1
+STORE @ bloc$3 : 8
+STORE @ _$0 : lettre
+COMPUTE @ lettre : lettre + 33
+STORE @ _$1 : lettre
+COMPUTE @ k : 0 - 1
+STORE @ _$2 : k
+ENDPROGRAM
@@ -0,0 +1,18 @@
+break 8 if k == 6
+continue
+print a
+x f$0..6
+reverse-step 4
+print a
+x f$0..6
+reverse-step
+print k
+break 11 if k == 39
+remove break 1
+continue
+reverse-continue
+print k
+reverse-step
+step 3
+print a
+continue
@@ -0,0 +1,4 @@
+# pas en arriere : reverse-step defait les ecritures (variables et tas),
+# reverse-continue remonte jusqu'au debut du journal, que --undo=64
+# borne ; on peut repartir en avant depuis le passe
+$PROJ tst/check/fibo.m 0 --undo=64 --script=tst/check/reverse.cmd
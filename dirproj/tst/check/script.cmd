@@ -0,0 +1,11 @@
+# une ligne de commentaire, puis une ligne vide
+
+frobnicate
+step deux
+print
+status
+step 2
+print somme
+continue
+print somme
+step
@@ -0,0 +1,7 @@
+# une session --script : les commentaires et lignes vides sont sautes,
+# chaque commande ratee donne une ligne @error, et apres la fin du
+# processus print marche encore, step non ; un programme qui ne se charge
+# pas ne lance pas le debugger
+$PROJ tst/check/compte.m 0 --script=tst/check/script.cmd
+echo "exit $?"
+$PROJ tst/check/syntaxe.m 0 --script=tst/check/script.cmd
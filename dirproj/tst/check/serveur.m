@@ -0,0 +1,7 @@
+PROGRAM
+NEW @ limite : 42
+NEW @ tours : 0
+WHILE @ 1 (limite) REPEAT
+  COMPUTE @ tours : tours + 1
+ENDWHILE @ 1
+ENDPROGRAM
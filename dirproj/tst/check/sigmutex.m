@@ -0,0 +1,17 @@
+PROGRAM
+NEW @ pid : 5
+NEW @ attente : 1
+SIGNAL
+COPY @ attente : 0
+ENDSIGNAL
+MUTEX @ _ : _P
+FORK @ pid
+WHILE @ 1 (pid) REPEAT
+  WHILE @ 2 (attente) REPEAT
+    COPY @ attente : attente
+  ENDWHILE @ 2
+  COPY @ pid : 0
+ENDWHILE @ 1
+SIGADD @ 1
+MUTEX @ _ : _P
+ENDPROGRAM
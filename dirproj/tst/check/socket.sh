@@ -0,0 +1,17 @@
+# le debugger sur une socket Unix : chaque reponse finit par @done, une
+# commande ratee donne @error ; un client qui part laisse la place au
+# suivant, une ligne trop longue ferme la connexion, et quit termine
+# la simulation
+socket=/tmp/check-socket.$$
+$PROJ tst/check/serveur.m 0 --dbg-socket=$socket &
+serveur=$!
+sleep 1
+printf 'print limite\nfrobnicate\nshow proc\nbreak 99\n' |
+$PROJ --attach=$socket
+echo "client $?"
+awk 'BEGIN { while (n++ < 5000) printf "x"; print "" }' |
+$PROJ --attach=$socket
+echo "client $?"
+printf 'modify limite 7\nprint limite\nquit\n' | $PROJ --attach=$socket
+echo "client $?"
+wait $serveur
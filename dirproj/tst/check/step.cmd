@@ -0,0 +1,16 @@
+finish
+step 5
+next
+print j
+print total
+until 8
+print i
+print j
+finish
+print j
+finish
+print i
+step 0
+until 3
+next
+continue
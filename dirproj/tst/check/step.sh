@@ -0,0 +1,3 @@
+# les pas multiples, faits sans repasser par le prompt : step N, next
+# (un WHILE entier), finish (sortie du WHILE courant) et until
+$PROJ tst/check/imbrique.m 0 --script=tst/check/step.cmd
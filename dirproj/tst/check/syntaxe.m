@@ -0,0 +1,4 @@
+PROGRAM
+NEW @ i : 0
+COMPUTE @ i : i + i * i
+ENDPROGRAM
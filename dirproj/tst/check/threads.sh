@@ -0,0 +1,9 @@
+# les elus de chaque tick sur des threads de travail : les statistiques
+# (les elections restent sur le thread principal), puis trois processus
+# qui incrementent une case partagee sous le mutex, un petit quantum
+# pour que les sections critiques se croisent
+$PROJ 'tst/check/compte.m tst/check/compte.m tst/check/compte.m' 0 \
+      --threads=2 --stats --seed=1 --script=/dev/null
+echo "exit $?"
+$PROJ 'tst/check/partage.m tst/check/partage.m tst/check/partage.m' 0 \
+      --threads=3 --quantum=7 --seed=1 --script=/dev/null
@@ -0,0 +1,11 @@
+trace 5 n
+trace 7 pid
+trace 5 inconnue
+trace 40 n
+show trace
+break 8
+continue
+tdump
+remove trace 2
+remove trace 2
+show trace
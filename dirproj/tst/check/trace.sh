@@ -0,0 +1,9 @@
+# tracepoints : rien ne s'arrete, chaque passage (pere et fils) est
+# note dans l'anneau ; tdump le relit, et ce qui reste est affiche a
+# la fin de la simulation
+$PROJ tst/check/famille.m 0 --seed=1 --script=tst/check/trace.cmd
+echo "exit $?"
+# plus de passages que l'anneau n'a de places : les plus anciens sont
+# ecrases, et le compte le dit
+echo 'trace 3 i' |
+$PROJ tst/check/longue.m 0 --script=/dev/stdin 2>&1 | sed -n '/^Trace:/p; $p'
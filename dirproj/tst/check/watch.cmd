@@ -0,0 +1,15 @@
+watch compteur
+watch inconnue
+continue
+print compteur
+remove watch 1
+watch pile$2
+continue
+x pile$0..3
+watch _$3
+watch k
+show watch
+continue
+continue
+continue
+continue
@@ -0,0 +1,13 @@
+PROGRAM
+NEW @ compteur : 0
+NEW @ pile : 0
+NEW @ k : 0
+WHILE @ 1 (k < 4) REPEAT
+  STORE @ pile$k : compteur
+  COMPUTE @ compteur : compteur + 10
+  COMPUTE @ k : k + 1
+ENDWHILE @ 1
+STORE @ _$3 : compteur
+COMPUTE @ k : k + 0
+PRINT @ "compteur ",compteur,"\n"
+ENDPROGRAM
@@ -0,0 +1,4 @@
+# watchpoints sur une variable, une case du tas et la memoire partagee :
+# arret juste apres l'ecriture qui change la valeur ; reecrire la meme
+# valeur (k : k + 0) n'arrete pas
+$PROJ tst/check/watch.m 0 --script=tst/check/watch.cmd
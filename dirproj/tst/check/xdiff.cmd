@@ -0,0 +1,16 @@
+x bloc$0..3
+xdiff
+break 8
+continue
+xdiff
+xdiff
+x bloc$0..8 x
+x bloc$2
+step 6
+xdiff
+x _$0..2 c
+x _$2 u
+x _$2 o
+x bloc$3..1
+x zut$0
+xdiff z
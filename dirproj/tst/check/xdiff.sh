@@ -0,0 +1,4 @@
+# x et xdiff sur le tas et la memoire partagee : les formats, et les
+# cases changees depuis l'arret precedent (egales, elles sont groupees ;
+# un second xdiff au meme arret redonne la meme chose)
+$PROJ tst/check/remplir.m 0 --script=tst/check/xdiff.cmd
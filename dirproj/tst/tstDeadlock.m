@@ -0,0 +1,19 @@
+PROGRAM
+NEW @ pid : 5
+NEW @ waitFils : 1
+STORE @ _$1 : waitFils
+MUTEX @ _ : _P
+FORK @ pid
+WHILE @ 1 (pid) REPEAT
+  PRINT @ "le pere attend le fils, mutex en main\n"
+  WHILE @ 12 (waitFils) REPEAT
+    LOAD    @ waitFils : _$1
+  ENDWHILE @ 12
+  MUTEX @ _ : _V
+  COPY @ pid : 0
+ENDWHILE @ 1
+MUTEX @ _ : _P
+NEW @ zero : 0
+STORE @ _$1 : zero
+MUTEX @ _ : _V
+ENDPROGRAM
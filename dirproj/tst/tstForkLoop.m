@@ -0,0 +1,11 @@
+PROGRAM
+NEW @ n : 3000
+NEW @ pid : 1
+WHILE @ 1 (n) REPEAT
+  FORK @ pid
+  COMPUTE @ n : n - 1
+  COMPUTE @ pid : pid != 0
+  COMPUTE @ n : n * pid
+ENDWHILE @ 1
+PRINT @ "fini\n"
+ENDPROGRAM
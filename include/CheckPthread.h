@@ -0,0 +1,21 @@
+/**
+ *
+ * @File : CheckPthread.h
+ *
+ * @Synopsis : verification du code de retour des fonctions pthread
+ *
+ **/
+
+#ifndef __CHECKPTHREAD_H__
+#define __CHECKPTHREAD_H__
+
+namespace ProcDebug {
+
+  // les fonctions pthread rendent le code d'erreur au lieu de
+  // positionner errno : on le fait, et on leve une CExc qui l'affiche
+  // (definie dans ParEngine.cxx)
+  void checkPthread (const int res, const char *fctName);
+
+} // namespace ProcDebug
+
+#endif /* __CHECKPTHREAD_H__ */
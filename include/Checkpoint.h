@@ -0,0 +1,94 @@
+/**
+ *
+ * @File : Checkpoint.h
+ *
+ * @Synopsis : sauvegarde de tout l'etat de la simulation dans un fichier,
+ *             et restauration
+ *
+ **/
+
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include <string>
+#include <vector>
+
+#include "ProcDebug.h"
+
+namespace ProcDebug {
+
+  // format du fichier : "PDC1", puis uniquement des entiers de longueur
+  // variable (7 bits par octet, comme le journal, voir Journal.h), les
+  // valeurs signees en zigzag ; les chaines sont precedees de leur
+  // longueur, et la memoire (tas, memoire partagee) est ecrite par plages
+  // de cases egales : un tas jamais touche tient en quelques octets.
+  //
+  //   global     : pids, sorties des fils liberes, pids libres, fils a
+  //                liberer, mutex, memoire partagee
+  //   par pid    : 0 si libre, sinon 1, le nom du programme, l'etat,
+  //                le masque de SIGNAL, les valeurs des symboles, le tas,
+  //                puis programCounter et condEval de chaque noeud des
+  //                arbres proGram et hanDler, en ordre prefixe
+  //   ordonnanceur : files des CPUs, tick, affinites et statistiques
+  //
+  // les arbres eux-memes ne sont pas ecrits : la restauration les
+  // recopie depuis les programmes charges, qui doivent donc etre les
+  // memes (meme nom, meme nombre d'instructions et de symboles). un
+  // processus trace par le debugger, ou dont le READ (ou DEVREAD,
+  // DEVWRITE) attend, est sauve comme en attente, et le journal
+  // d'annulation, les watchpoints, le contenu du peripherique, la
+  // suite des tirages aleatoires et le nombre de pas (celui des
+  // tracepoints, qui repart de 0) ne sont pas sauves.
+  //
+  // save() ecrit le fichier d'un seul write() ; restore() le projette en
+  // memoire (mmap()) et ne touche a la simulation qu'une fois tout relu :
+  // sur un fichier invalide (CExc), l'etat courant reste intact
+
+  class Checkpoint {
+  public:
+    static void save    (const ProcInfo &pInfo, const std::string &fileName);
+    static void restore (ProcInfo *pInfo, const std::string &fileName);
+
+  private:
+    std::string                fileName;
+    std::vector<unsigned char> out;    // save()
+    const unsigned char      * in;     // restore() : le fichier projete
+    const unsigned char      * inEnd;
+
+    Checkpoint (const std::string &fName) :
+        fileName (fName), in (0), inEnd (0) {}
+
+    void putVarint (unsigned long v) {
+        for(; v >= 0x80; v >>= 7) {
+            out . push_back(static_cast<unsigned char>(v | 0x80));
+        }
+        out . push_back(static_cast<unsigned char>(v));
+    }
+    void putInt    (const int v) {
+        putVarint((static_cast<unsigned int>(v) << 1) ^
+                  static_cast<unsigned int>(v >> 31));
+    }
+    void putString (const std::string &str);
+    void putCells  (const std::vector<int> &cells);
+    void putTree   (const ProcInfo::ProcInstruction *instr);
+
+    unsigned long getVarint (void);
+    int           getInt    (void) {
+        const unsigned int v (getVarint());
+        return static_cast<int>(v >> 1) ^ -static_cast<int>(v & 1);
+    }
+    std::string   getString (void);
+    void          getCells  (std::vector<int> *pCells);
+    void          getTree   (ProcInfo::ProcInstruction *instr);
+    int           getPid    (const unsigned long nbPid);
+    unsigned long getCount  (const unsigned long maxCount);
+    void          checkCount(const unsigned long expected,
+                             const char *what);
+
+    Checkpoint (const Checkpoint &);             // pas de copie
+    Checkpoint & operator = (const Checkpoint &);
+  };
+
+} // namespace ProcDebug
+
+#endif /* __CHECKPOINT_H__ */
@@ -0,0 +1,90 @@
+/**
+ *
+ * @File : DbgServer.h
+ *
+ * @Synopsis : le debugger servi sur une socket Unix, a plusieurs clients
+ *
+ **/
+
+#ifndef __DBGSERVER_H__
+#define __DBGSERVER_H__
+
+#include <string>
+#include <deque>
+#include <map>
+#include <pthread.h>
+
+namespace ProcDebug {
+
+  // --dbg-socket=<chemin> : le debugger non-stop n'a plus de console, il
+  // ecoute sur une socket Unix ; l'entree et la sortie standard restent
+  // aux READ et PRINT des programmes, et il n'y a plus besoin de SIGQUIT
+  // pour entrer (il suffit de se connecter : proj.run --attach=<chemin>).
+  //
+  // le protocole est en lignes : une commande du debugger par ligne (les
+  // memes qu'au prompt : break, step, continue, print, status...), et
+  // pour reponse les lignes du mode machine ("@cmd ...", "@value ...",
+  // "@stop ...", et les messages), terminees par une ligne "@done". les
+  // arrets qui ne sont la reponse de personne (breakpoint d'un continue,
+  // watchpoint, interblocage, SIGQUIT) sont envoyes a tous les clients,
+  // entre deux reponses.
+  //
+  // un seul thread, une boucle poll(), s'occupe de toutes les sockets :
+  // il accepte les clients, decoupe leurs lignes en commandes et ecrit ce
+  // qu'on leur envoie, sans jamais bloquer sur un client lent. comme pour
+  // DbgThread, c'est le thread principal qui prend les commandes entre
+  // deux ticks et les execute
+
+  class DbgServer {
+  public:
+    DbgServer (const std::string &path);
+    // envoie ce qui reste (une seconde au plus), puis ferme tout
+    ~DbgServer();
+
+    // la commande suivante et son client ; avec qWait, attend qu'il en
+    // arrive une (d'un client deja la, ou d'un nouveau)
+    bool takeCommand (std::string *pLine, int *pClient, const bool qWait);
+    // la reponse a une commande, puis "@done"
+    void reply       (const int client, const std::string &text);
+    // un evenement, pour tous
+    void broadcast   (const std::string &text);
+
+    // le client de la console : stdin vers la socket, la socket vers
+    // stdout, jusqu'a ce que l'un des deux se ferme
+    static int attach (const std::string &path);
+
+  private:
+    struct Client {
+        int          fd;
+        std::string  in;        // la ligne commencee
+        std::string  out;       // pas encore ecrit
+        bool         qEof;      // n'enverra plus rien : ferme des qu'il
+        unsigned int nbPending; // a toutes ses reponses
+    };
+
+    std::string                                path;
+    int                                        listenFd;
+    int                                        wakeFd[2]; // reveille poll()
+    pthread_t                                  thread;
+    pthread_mutex_t                            lock;      // ce qui suit
+    pthread_cond_t                             cmdReady;
+    std::deque<std::pair<int, std::string> >   commands;
+    std::map<int, Client>                      clients;   // par numero
+    int                                        nextClient;
+    bool                                       qStop;
+
+    void         wake       (void);
+    void         serverLoop (void);
+    void         readClient (const int id);
+    void         writeClient(const int id);
+    // sous lock : ferme le client s'il n'attend plus rien
+    bool         closeIfDone(std::map<int, Client>::iterator i);
+    static void *serverMain (void *);
+
+    DbgServer (const DbgServer &);             // pas de copie
+    DbgServer & operator = (const DbgServer &);
+  };
+
+} // namespace ProcDebug
+
+#endif /* __DBGSERVER_H__ */
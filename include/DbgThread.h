@@ -0,0 +1,59 @@
+/**
+ *
+ * @File : DbgThread.h
+ *
+ * @Synopsis : debugger non-stop : un thread lit les commandes, le thread
+ *             principal les execute entre deux ticks
+ *
+ **/
+
+#ifndef __DBGTHREAD_H__
+#define __DBGTHREAD_H__
+
+#include <iostream>
+#include <string>
+#include <deque>
+#include <pthread.h>
+
+namespace ProcDebug {
+
+  // en mode non-stop (--non-stop), le processus arrete par le debugger
+  // reste en STAT_TRACEEND, et l'ordonnanceur continue de faire tourner
+  // tous les autres. le thread lecteur ne fait que getline() et remplir
+  // la file ; c'est le thread principal qui prend les commandes entre
+  // deux ticks et les execute (MiniDbg::Executer()) : la simulation,
+  // elle, ne voit jamais qu'un seul thread.
+  //
+  // le thread lecteur est detache : a la fin de la simulation il est
+  // peut-etre bloque dans getline(), on ne l'attend pas
+
+  class DbgThread {
+  public:
+    DbgThread (std::istream &in);
+    ~DbgThread();
+
+    // la commande suivante, s'il y en a une ; avec qWait, attend qu'il
+    // en arrive une (tous les processus sont arretes). faux s'il n'y en
+    // a pas, ou plus : voir qAtEnd()
+    bool takeCommand (std::string *pLine, const bool qWait);
+    // l'entree est finie et toutes ses commandes ont ete prises
+    bool qAtEnd      (void);
+
+  private:
+    std::istream            & in;
+    pthread_t                 thread;
+    pthread_mutex_t           lock;
+    pthread_cond_t            cmdReady;
+    std::deque<std::string>   commands;
+    bool                      qEof;
+
+    void         readerLoop (void);
+    static void *readerMain (void *);
+
+    DbgThread (const DbgThread &);             // pas de copie
+    DbgThread & operator = (const DbgThread &);
+  };
+
+} // namespace ProcDebug
+
+#endif /* __DBGTHREAD_H__ */
@@ -0,0 +1,86 @@
+/**
+ *
+ * @File : Device.h
+ *
+ * @Synopsis : peripherique bloc simule, pour DEVREAD et DEVWRITE
+ *
+ **/
+
+#ifndef __DEVICE_H__
+#define __DEVICE_H__
+
+#include <iostream>
+#include <vector>
+#include <deque>
+
+namespace ProcDebug {
+
+  // un disque de nbBlocks blocs de blockWords entiers, qui sert ses
+  // requetes une a une, dans l'ordre d'arrivee. le temps est celui de
+  // l'ordonnanceur (un tick par tour de tous les CPUs) : une requete
+  // deposee au tick t, derriere celles deja en cours, est finie
+  //     latency + ceil(blockWords / bandwidth)
+  // ticks apres que le disque s'est libere. pendant ce temps le
+  // processus est en STAT_IOWAIT, hors des files, et les autres tournent
+  // (voir ProcInfo::completeDeviceIo()).
+  //
+  //   DEVREAD  @ a : b   le bloc b dans le tas, de a$0 a a$<blockWords-1>
+  //   DEVWRITE @ a : b   l'inverse
+  //
+  // le transfert lui-meme est fait quand la requete est finie : le
+  // processus, reveille, refait son instruction (comme READ). --device=
+  // change les parametres, --stats affiche le debit et l'occupation
+
+  class Device {
+  public:
+    static const unsigned int DEFAULT_LATENCY     = 8;
+    static const unsigned int DEFAULT_BANDWIDTH   = 4;  // entiers par tick
+    static const unsigned int DEFAULT_BLOCK_WORDS = 16;
+    static const unsigned int DEFAULT_BLOCKS      = 256;
+
+    Device ();
+
+    // au demarrage seulement (le contenu est remis a zero)
+    void configure (const unsigned int latency, const unsigned int bandwidth,
+                    const unsigned int blockWords,
+                    const unsigned int nbBlocks);
+
+    unsigned int blockWords (void) const { return nbWords; }
+    unsigned int blockCount (void) const { return blocks . size(); }
+    std::vector<int> & block (const unsigned int b) { return blocks[b]; }
+
+    // depose la requete de procPid au tick now
+    void submit   (const int procPid, const bool qWrite,
+                   const unsigned long now);
+    // la plus ancienne requete finie au tick now, s'il y en a une
+    bool takeDone (const unsigned long now, int *pProcPid);
+    bool qBusy    (void) const { return pending . size(); }
+    // checkpoint restaure au tick now : les requetes en cours seront
+    // refaites, sur un disque libre a partir de now
+    void cancelAll (const unsigned long now) {
+        pending . clear();
+        freeTick = now;
+    }
+
+    void dumpStat (std::ostream *s, const unsigned long ticks) const;
+
+  private:
+    struct Request {
+        int           procPid;
+        unsigned long submitTick, doneTick;
+    };
+
+    unsigned int                    latency, bandwidth, nbWords;
+    std::vector<std::vector<int> >  blocks;
+    std::deque<Request>             pending;   // doneTick croissants
+    unsigned long                   freeTick;  // fin de la derniere
+
+    // statistiques
+    unsigned long  nbReads, nbWrites;
+    unsigned long  busyTicks;     // ticks passes a servir
+    unsigned long  totalTicks;    // attente + service, de toutes
+  };
+
+} // namespace ProcDebug
+
+#endif /* __DEVICE_H__ */
@@ -0,0 +1,120 @@
+/**
+ *
+ * @File : InputFeed.h
+ *
+ * @Synopsis : les valeurs des READ sans clavier : un fichier d'entiers,
+ *             une constante ou un tirage aleatoire
+ *
+ **/
+
+#ifndef __INPUTFEED_H__
+#define __INPUTFEED_H__
+
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+
+namespace ProcDebug {
+
+  // --input=[<k>:]<source>, <source> etant
+  //   file:<fichier>              les entiers du fichier, dans l'ordre
+  //   const:<v>                   toujours v
+  //   random:<min>:<max>[:<graine>] tires dans [min, max] (graine par
+  //                               defaut : celle de l'ordonnanceur)
+  // avec <k>, pour le k-ieme programme de la liste (et ses fils de FORK,
+  // et les autres instances du meme fichier) ; sans, pour tous ceux qui
+  // n'en ont pas un a eux : ils se partagent alors la suite.
+  //
+  // le fichier est lu et analyse en entier a la creation : un READ ne
+  // fait plus qu'avancer un indice. epuise, on le dit une fois et on
+  // repasse au clavier. le tirage a son propre generateur, qui ne touche
+  // pas a rand() (les choix de l'ordonnanceur restent les memes)
+
+  class InputFeed {
+  public:
+    InputFeed (const std::string &source, const unsigned int defaultSeed);
+
+    // faux si la source est epuisee : le READ lit alors cin
+    bool next (int *pValue) {
+        switch(kind) {
+            case FEED_CONST:  *pValue = constValue; return true;
+            case FEED_RANDOM: *pValue = nextRandom(); return true;
+            default: break;
+        }
+        if(pos == values . size()) return qAtEnd();
+        *pValue = values[pos++];
+        return true;
+    }
+    // vrai si next() ne rend jamais faux
+    bool qEndless (void) const { return kind != FEED_FILE; }
+
+  private:
+    enum FeedKind { FEED_FILE, FEED_CONST, FEED_RANDOM };
+
+    FeedKind          kind;
+    std::string       source;
+    std::vector<int>  values;      // FEED_FILE
+    unsigned int      pos;
+    bool              qWarned;
+    int               constValue;  // FEED_CONST, et min de FEED_RANDOM
+    unsigned int      range;       // FEED_RANDOM : max - min + 1, 0 : 2^32
+    unsigned int      state;       // FEED_RANDOM : xorshift
+
+    void         readFile   (const std::string &fileName);
+    int          nextRandom (void);
+    bool         qAtEnd     (void);
+  };
+
+  // l'entree standard des READ qui n'ont pas de source, lue par read()
+  // et decoupee en lignes : poll() prend ce qui est arrive sans bloquer
+  // le simulateur (READ asynchrone, voir ProcInfo::pollInput()), getLine()
+  // attend la ligne suivante (READ synchrone : debugger, journal). a la
+  // fin de l'entree, une derniere ligne sans '\n' compte quand meme
+
+  class StdinLines {
+  public:
+    StdinLines (const int f = 0) : fd (f), qEof (false) {}
+
+    // lit ce qui est arrive ; timeoutMs comme pour poll() (-1 : attend)
+    void         poll      (const int timeoutMs);
+    unsigned int lineCount (void) const { return lines . size(); }
+    bool         qAtEnd    (void) const { return qEof && lines . empty(); }
+    // faux s'il n'y a pas de ligne complete
+    bool         takeLine  (std::string *pLine);
+    // faux seulement a la fin de l'entree
+    bool         getLine   (std::string *pLine);
+
+  private:
+    int                      fd;
+    std::deque<std::string>  lines;
+    std::string              partial;
+    bool                     qEof;
+  };
+
+  // les sources de la ligne de commande, par nom de programme
+  class InputFeeds {
+  public:
+    InputFeeds () : shared (0) {}
+    ~InputFeeds();
+
+    // progName vide : la source commune ; prend feed, meme sur CExc
+    void        add  (const std::string &progName, InputFeed *feed);
+    // 0 : READ lit cin
+    InputFeed * find (const std::string &progName) const {
+        const std::map<std::string, InputFeed *>::const_iterator
+            it (byProg . find(progName));
+        return it == byProg . end() ? shared : it -> second;
+    }
+
+  private:
+    InputFeed                          * shared;
+    std::map<std::string, InputFeed *>   byProg;
+
+    InputFeeds (const InputFeeds &);             // pas de copie
+    InputFeeds & operator = (const InputFeeds &);
+  };
+
+} // namespace ProcDebug
+
+#endif /* __INPUTFEED_H__ */
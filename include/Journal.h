@@ -0,0 +1,90 @@
+/**
+ *
+ * @File : Journal.h
+ *
+ * @Synopsis : enregistrement et rejeu des elections de l'ordonnanceur
+ *             et des valeurs lues par READ
+ *
+ **/
+
+#ifndef __JOURNAL_H__
+#define __JOURNAL_H__
+
+#include <string>
+#include <vector>
+
+namespace ProcDebug {
+
+  // format du fichier : "PDJ1", la graine (4 octets, poids faible
+  // d'abord), puis une entree par election ou par READ, en entiers de
+  // longueur variable (7 bits par octet, le bit de poids fort dit qu'il
+  // en reste) :
+  //   election : (pid + 1) << 1          -- bit 0 a 0, un octet si pid < 63
+  //   READ     : l'octet 1, puis la valeur en zigzag (0,-1,1,-2... ->
+  //              0,1,2,3...) pour que les petits negatifs restent courts
+  //   fin de l'entree vue par un READ : l'octet 3 (le processus s'arrete)
+  //
+  // en enregistrement, une election coute un ou deux octets ecrits dans
+  // un tampon, vide par write() quand il est plein et a la destruction
+
+  class Journal {
+  public:
+    enum JournalMode { JOURNAL_RECORD, JOURNAL_REPLAY, JOURNAL_OFF };
+
+    Journal (const std::string &fileName, const JournalMode mode,
+             const unsigned int seed = 0);
+    ~Journal();
+
+    unsigned int getSeed      (void) const { return seed; }
+    bool         qRecording   (void) const { return mode == JOURNAL_RECORD; }
+    // faux aussi une fois le journal epuise : on continue alors en direct
+    bool         qReplaying   (void) const { return mode == JOURNAL_REPLAY; }
+
+    void recordElection (const int procPid) {
+        putVarint(static_cast<unsigned int>(procPid + 1) << 1);
+    }
+    void recordRead     (const int value) {
+        putByte(READ_TAG);
+        putVarint((static_cast<unsigned int>(value) << 1) ^
+                  static_cast<unsigned int>(value >> 31));
+    }
+    void recordInputEnd (void) { putByte(INPUT_END_TAG); }
+    // rendent faux si le journal est epuise ; levent CExc si l'entree
+    // suivante n'est pas du type attendu (le rejeu a diverge).
+    // replayRead() met *pqInputEnd a vrai pour une fin de l'entree
+    bool replayElection (int *pProcPid);
+    bool replayRead     (int *pValue, bool *pqInputEnd);
+
+  private:
+    static const unsigned char READ_TAG      = 1;
+    static const unsigned char INPUT_END_TAG = 3;
+    static const unsigned int  BUF_SIZE = 4096;
+
+    JournalMode                mode;
+    std::string                fileName;
+    unsigned int               seed;
+    int                        fd;
+    unsigned char              buf[BUF_SIZE];  // enregistrement
+    unsigned int               bufLength;
+    std::vector<unsigned char> content;        // rejeu : tout le fichier
+    unsigned int               readPos;
+
+    void putByte (const unsigned char c) {
+        if(bufLength == BUF_SIZE) flush();
+        buf[bufLength++] = c;
+    }
+    void putVarint (unsigned int v) {
+        for(; v >= 0x80; v >>= 7) putByte(static_cast<unsigned char>(v|0x80));
+        putByte(static_cast<unsigned char>(v));
+    }
+    unsigned int getVarint (void);
+    bool         qAtEnd    (void);
+    void         flush     (void);
+
+    Journal (const Journal &);             // pas de copie
+    Journal & operator = (const Journal &);
+  };
+
+} // namespace ProcDebug
+
+#endif /* __JOURNAL_H__ */
@@ -12,6 +12,7 @@
 #include <sstream>
 #include <string>
 #include <vector>
+#include <map>
 
 #include "ProcDebug.h"
 
@@ -32,41 +33,178 @@ namespace ProcDebug
         // (e.g : pour une commande de 3 mots, le istream prend 188 octets
         // tandis que le vecteur n'en prend que 12)
         std::vector<std::string> m_Cmd;
-        std::vector<std::string> m_VarAAfficher; // à chaque step
-        std::vector<int>         m_Break; // devrait être unsigned mais dans
-                                          // ProcDebug les lignes sont int
+
+        // Les expressions du display, affichées à chaque arrêt :
+        // compilées (voir ProcInfo::CompiledExpr) à l'ajout, puis
+        // seulement quand le processus tracé change (SetProc(),
+        // changeproc), pour qu'un arrêt ne fasse plus que le calcul
+        struct Affichage
+        {
+            std::string              m_Texte;
+            std::string              m_Nom;   // le même, sans blancs
+            ProcInfo::CompiledExpr   m_Expr;
+            bool                     m_qResolue; // faux : une variable
+                                                 // n'est pas dans ce
+                                                 // programme
+        };
+        std::vector<Affichage>   m_Display;
+
+        // Un breakpoint est une ligne d'un programme (fichier), pour
+        // que changeproc vers un autre programme ne les mélange pas
+        struct BreakPoint
+        {
+            std::string m_ProgName;
+            int         m_Ligne; // devrait être unsigned mais dans
+                                 // ProcDebug les lignes sont int
+            std::string m_Cond;  // texte de la condition, vide sinon
+        };
+        std::vector<BreakPoint>  m_Break; // dans l'ordre de création,
+                                          // pour show et remove
+        // et un bit par ligne de chaque programme : continue ne teste
+        // qu'un bit par instruction, quel que soit le nombre de breakpoints,
+        // puis, seulement sur une ligne marquée, sa condition compilée
+        // (toujours vraie pour un breakpoint sans condition)
+        struct ProgBreaks
+        {
+            std::vector<bool>                   m_Bits;
+            std::vector<ProcInfo::CompiledCond> m_Conds;
+        };
+        typedef std::map<std::string, ProgBreaks> BreakBits_t;
+        BreakBits_t              m_BreakBits;
+
+        // Les watchpoints : la case surveillée est résolue une fois pour
+        // toutes (pour a$i, avec les valeurs de a et i au moment du watch)
+        struct WatchPoint
+        {
+            int                 m_Proc; // inutile pour _$<n>
+            ProcInfo::WatchKind m_Kind;
+            int                 m_Cell;
+            std::string         m_Texte;
+        };
+        std::vector<WatchPoint>  m_Watch;
+
+        std::string m_Restore; // vide si aucun restore n'est demandé
+        int         m_ListeSuite; // où reprend un list sans argument,
+                                  // -1 : autour de la ligne courante
+
+        // Les commandes viennent de m_In (cin, ou le script de --script) ;
+        // en mode machine, les arrêts et les valeurs sont écrits sur
+        // m_Sortie (cout) en lignes "@<type> clé=valeur...", et le reste
+        // (messages, usages, show) part sur cerr, par m_Msg. Rediriger()
+        // envoie les deux ailleurs (--dbg-socket : vers le client).
+        // Une commande qui échoue écrit dans Erreur() : à la fin de la
+        // commande, SignalerEchec() le passe à m_Msg et, en mode machine,
+        // en fait aussi une ligne "@error msg=<texte>" sur m_Sortie
+        std::istream &     m_In;
+        std::ostream       m_Msg;
+        std::ostream       m_Sortie;
+        std::ostringstream m_Erreur;
+        bool               m_qMachine;
+
+        // Non-stop (--non-stop) : pas de Prompt(), la boucle principale
+        // passe les lignes à Executer() entre deux ticks ; continue rend
+        // le processus à l'ordonnanceur, et m_Suivi est celui dont la
+        // boucle principale teste les breakpoints (VerifierBreak())
+        bool           m_qNonStop;
+        int            m_Suivi;
+
+        // La table des commandes, parcourue par Prompt()
+        struct Commande
+        {
+            const char * m_Nom;
+            void (MiniDbg::* m_Gerer) (void);
+        };
+        static const Commande s_Commandes [];
 
         bool m_GoOut; // pour le end et le quit,
                       // si on a envoyé plusieurs fois SIGQUIT,
 
       public :
-        MiniDbg              (ProcInfo *, int)         throw ();
+        MiniDbg              (ProcInfo *, int,
+                              std::istream & In = std::cin,
+                              bool qMachine = false,
+                              bool qNonStop = false)   throw ();
 
         ~MiniDbg () {}
 
         void SetProc         (int Proc)                throw ();
         int  GetProc         (void)                    throw ();
         void Prompt          (void)                    throw ();
+        // affiche l'écriture surveillée en attente, s'il y en a une
+        bool SignalerWatch   (void)                    throw ();
+        // le fichier d'un restore demandé, que la boucle principale
+        // fait entre deux ticks avant de relancer le débugger
+        bool PrendreRestore  (std::string * File)      throw ();
+        // une erreur survenue hors d'une commande (restore raté), signalée
+        // comme celles des commandes
+        void SignalerErreur  (const std::string & Texte) throw ();
+
+        void Executer        (const std::string & Ligne) throw ();
+        void FinDesCommandes (void)                    throw ();
+        void AfficherPrompt  (void)                    throw ();
+        // non-stop : arrête le processus Pid et le suit ; VerifierBreak()
+        // l'arrête s'il est le processus relancé et sur un breakpoint
+        void Arreter         (int Pid, const char * Raison) throw ();
+        void ArreterTout     (int Pid, const char * Raison) throw ();
+        bool VerifierBreak   (int Pid)                 throw ();
+        int  GetSuivi        (void) const { return m_Suivi; }
+        void Rediriger       (std::streambuf * Tampon) throw ();
 
       private :
 
+        std::ostream & Erreur (void)                   throw ()
+            { return m_Erreur; }
+        void SignalerEchec   (void)                    throw ();
+        // les variables du display, et la ligne "@stop" en mode machine
+        void Arret           (const char * Raison)     throw ();
+        // START_TRACE / END_TRACE, ou en non-stop le seul état
+        void Tracer          (int Pid)                 throw ();
+        void Detracer        (int Pid)                 throw ();
+
         void GererContinue   (void)                    throw ();
         void GererStep       (void)                    throw ();
+        void GererNext       (void)                    throw ();
+        void GererFinish     (void)                    throw ();
+        void GererUntil      (void)                    throw ();
+        void Avancer         (ProcInfo::StepMode Mode, unsigned long Arg,
+                              const char * Raison)     throw ();
+        void GererReverseStep     (void)               throw ();
+        void GererReverseContinue (void)               throw ();
         void GererPrint      (void)                    throw ();
         void GererDisplay    (void)                    throw ();
         void GererModify     (void)                    throw ();
         void GererBreak      (void)                    throw ();
         void GererShow       (void)                    throw ();
+        void GererList       (void)                    throw ();
+        void GererWatch      (void)                    throw ();
+        void GererTrace      (void)                    throw ();
+        void GererTdump      (void)                    throw ();
+        void GererX          (void)                    throw ();
+        void GererXdiff      (void)                    throw ();
+        bool ValeurIndice    (const std::string & Texte,
+                              int * pValeur)           throw ();
+        void AfficherCase    (int Valeur, char Format) throw ();
+        const ProcInfo::LineTable * ResoudreLigne (unsigned * pLigne,
+                                     const char * Quoi) throw ();
+        void GererCheckpoint (void)                    throw ();
+        void GererRestore    (void)                    throw ();
         void GererRemove     (void)                    throw ();
         void GererStop       (void)                    throw ();
         void GererStart      (void)                    throw ();
         void GererRestart    (void)                    throw ();
         void GererChangeProc (void)                    throw ();
+        void GererInterrupt  (void)                    throw ();
         void GererStatus     (void)                    throw ();
-        int  GererEnd        (void)                    throw ();
-        int  GererQuit       (void)                    throw ();
+        void GererEnd        (void)                    throw ();
+        void GererQuit       (void)                    throw ();
 
-        int AfficherVar      (const std::string & Var) throw ();
+        int AfficherExpr     (const std::string & Texte) throw ();
+        std::string TexteExpr (unsigned Debut)         throw ();
+        static std::string NomExpr (const std::string & Texte) throw ();
+        void ResoudreDisplay (void)                    throw ();
+        void AfficherDisplay (void)                    throw ();
+        void AfficherUnDisplay (std::ostream & Os, const Affichage & Aff)
+                                                       throw ();
 
     }; // MiniDbg
 
@@ -0,0 +1,85 @@
+/**
+ *
+ * @File : OutputCapture.h
+ *
+ * @Synopsis : la sortie des PRINT de chaque processus vers sa propre
+ *             destination, ecrite par un thread a part
+ *
+ **/
+
+#ifndef __OUTPUTCAPTURE_H__
+#define __OUTPUTCAPTURE_H__
+
+#include <string>
+#include <vector>
+#include <map>
+#include <pthread.h>
+
+namespace ProcDebug {
+
+  // --capture= : les PRINT ne vont plus sur la sortie standard, mais
+  //   CAPTURE_FILES  : dans un fichier par pid, <prefixe>.<pid>
+  //   CAPTURE_TAGGED : dans un seul fichier, ligne par ligne, chacune
+  //                    precedee de "[<pid>] " (les lignes commencees par
+  //                    plusieurs PRINT sont recollees)
+  //   CAPTURE_NONE   : nulle part
+  //
+  // seul le thread principal execute les PRINT (voir
+  // ProcInfo::qIsSerialInstruction()) : il n'y a qu'un producteur, et une
+  // seule file suffit, un anneau sans verrou qu'il remplit et que le
+  // thread ecrivain vide. le texte d'un PRINT y passe par swap(), sans
+  // copie. le thread principal n'attend que si l'anneau est plein ; les
+  // ouvertures et les write() sont faits par l'ecrivain. le destructeur
+  // attend que tout soit ecrit.
+  //
+  // un pid reutilise (fils libere, voir reapZombies()) continue le meme
+  // fichier
+
+  class OutputCapture {
+  public:
+    enum CaptureMode { CAPTURE_FILES, CAPTURE_TAGGED, CAPTURE_NONE };
+
+    static const unsigned int RING_SIZE = 4096; // puissance de 2
+
+    // path : le prefixe (CAPTURE_FILES) ou le fichier (CAPTURE_TAGGED)
+    OutputCapture (const CaptureMode mode, const std::string &path);
+    ~OutputCapture();
+
+    // prend le texte d'un PRINT (*pText est vide au retour)
+    void put (const int procPid, std::string *pText);
+
+  private:
+    struct Slot {
+        int         procPid;
+        std::string text;
+    };
+
+    CaptureMode               mode;
+    std::string               path;
+    std::vector<Slot>         ring;
+    // head n'est ecrit que par le producteur, tail que par l'ecrivain
+    volatile unsigned long    head;
+    volatile unsigned long    tail;
+    volatile bool             qStop;
+    pthread_t                 thread;
+
+    // a l'ecrivain seul
+    std::map<int, int>          fds;       // CAPTURE_FILES : pid -> fd
+    int                         taggedFd;  // CAPTURE_TAGGED
+    std::map<int, std::string>  pending;   // CAPTURE_TAGGED : ligne
+                                           // commencee, par pid
+    bool                        qFailed;   // une erreur : on jette tout
+
+    void         writerLoop (void);
+    static void *writerMain (void *);
+    void         consume    (Slot *pSlot);
+    void         writeAll   (const int fd, const std::string &str);
+    void         finish     (void);        // lignes commencees, close()
+
+    OutputCapture (const OutputCapture &);             // pas de copie
+    OutputCapture & operator = (const OutputCapture &);
+  };
+
+} // namespace ProcDebug
+
+#endif /* __OUTPUTCAPTURE_H__ */
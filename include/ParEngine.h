@@ -0,0 +1,80 @@
+/**
+ *
+ * @File : ParEngine.h
+ *
+ * @Synopsis : moteur parallele : les processus simules elus a un tick
+ *             avancent en meme temps sur un groupe de threads
+ *
+ **/
+
+#ifndef __PARENGINE_H__
+#define __PARENGINE_H__
+
+#include <vector>
+#include <deque>
+#include <pthread.h>
+
+#include "ProcDebug.h"
+
+namespace ProcDebug {
+
+  // a chaque tick, le thread principal elit un processus par CPU simule
+  // (l'ordonnanceur reste donc mono-thread), puis runTick() les
+  // distribue aux threads de travail, chacun avec sa propre file ; un
+  // thread qui a vide la sienne vole par derriere dans celle des autres.
+  // chaque processus avance d'au plus 'quantum' pas (ProcInfo::runQuantum)
+  // puis le thread principal finit le travail (ProcInfo::finishQuantum) :
+  // instruction d'entree/sortie ou FORK en attente, et remise en file.
+  //
+  // l'etat prive d'un processus (symbolTable, heapMemory, arbre
+  // d'instructions) n'est touche que par le thread qui l'avance ; la
+  // memoire partagee et le mutex passent par des operations atomiques,
+  // et la table des processus n'est agrandie (FORK) que par le thread
+  // principal, pendant que les threads de travail attendent le tick suivant
+
+  class ParEngine {
+  public:
+    ParEngine (ProcInfo *pI, const int nbThreads, const int quantum);
+    ~ParEngine();
+
+    void runTick (const std::vector<int> &electedProcs);
+
+    static const int DEFAULT_QUANTUM = 64;
+
+  private:
+    struct Task {
+        int  procPid;
+        int  steps;
+        bool qSerial;
+        Task(const int pid) : procPid(pid), steps(0), qSerial(false) {}
+    };
+    struct Worker {
+        ParEngine       * engine;
+        pthread_t         thread;
+        pthread_mutex_t   lock;  // protege tasks, a cause du vol
+        std::deque<int>   tasks; // indices dans taskList
+    };
+
+    ProcInfo              * pInfo;
+    int                     quantum;
+    std::vector<Worker *>   workers;
+    std::vector<Task>       taskList;
+
+    pthread_mutex_t         tickLock;
+    pthread_cond_t          tickStart;
+    pthread_cond_t          tickEnd;
+    unsigned long           tickGeneration;
+    int                     busyWorkers;
+    bool                    qStop;
+
+    bool         popTask    (Worker *self, int *taskIndex);
+    void         workerLoop (Worker *self);
+    static void *workerMain (void *);
+
+    ParEngine (const ParEngine &);             // pas de copie
+    ParEngine & operator = (const ParEngine &);
+  };
+
+} // namespace ProcDebug
+
+#endif /* __PARENGINE_H__ */
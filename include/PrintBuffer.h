@@ -0,0 +1,87 @@
+/**
+ *
+ * @File : PrintBuffer.h
+ *
+ * @Synopsis : tampon de la sortie standard des PRINT, vide selon une
+ *             politique
+ *
+ **/
+
+#ifndef __PRINTBUFFER_H__
+#define __PRINTBUFFER_H__
+
+#include <string>
+#include <signal.h>
+
+namespace ProcDebug {
+
+  // les PRINT ne font plus un write() chacun : ils remplissent un tampon,
+  // vide d'un seul write() selon la politique (--output=) :
+  //   FLUSH_ALWAYS : a la fin de chaque PRINT, comme avant (pour suivre
+  //                  l'entrelacement des processus au plus pres)
+  //   FLUSH_LINE   : a la fin d'un PRINT qui a ecrit un '\n'
+  //   FLUSH_FULL   : seulement quand il est plein
+  // et dans tous les cas : avant un READ, a l'entree dans le debugger, et
+  // a la fin (destructeur). par defaut FLUSH_LINE sur un terminal,
+  // FLUSH_FULL sinon, comme stdio.
+  //
+  // le reste de la sortie standard (debugger...) passe par cout : flush()
+  // vide cout d'abord, et qui ecrit sur cout apres un PRINT doit appeler
+  // flush() avant, pour que l'ordre soit garde.
+  //
+  // flush() peut etre appele depuis le traitant de SIGQUIT (debugger) : au
+  // milieu d'un PRINT, il ne fait rien, le PRINT finira de le remplir
+
+  class PrintBuffer {
+  public:
+    enum FlushPolicy { FLUSH_ALWAYS, FLUSH_LINE, FLUSH_FULL };
+
+    static const unsigned int BUF_SIZE   = 64 * 1024;
+    static const unsigned int INT_DIGITS = 12; // "-2147483648"
+
+    // ecrit value en decimal juste avant end, rend le debut
+    static char * formatInt (const int value, char *end);
+    // ... ou a partir de p, rend la fin
+    static char * appendInt (const int value, char *p);
+
+    PrintBuffer (const int fd = 1);
+    ~PrintBuffer();
+
+    void        setPolicy (const FlushPolicy pol) { policy = pol; }
+    FlushPolicy getPolicy (void) const            { return policy; }
+
+    // un PRINT : beginPrint(), ses operandes, puis endPrint(), qui
+    // applique la politique
+    void beginPrint (void) { qInPrint = 1; qNewLine = false; }
+    void put        (const int value);
+    void put        (const std::string &str) { put(str . data(), str . size()); }
+    // ou, pour un PRINT compile, directement dans le tampon : reserve()
+    // rend la place pour length octets (0 s'il ne les aura jamais),
+    // commit() la prend jusqu'a end
+    char * reserve  (const unsigned int length);
+    void   commit   (const char *end, const bool qWithNewLine) {
+        bufLength = end - buf;
+        if(qWithNewLine) qNewLine = true;
+    }
+    void endPrint   (void);
+
+    void flush      (void);
+
+  private:
+    int                   fd;
+    FlushPolicy           policy;
+    char                  buf[BUF_SIZE];
+    unsigned int          bufLength;
+    bool                  qNewLine;  // le PRINT en cours a ecrit un '\n'
+    volatile sig_atomic_t qInPrint;
+
+    void put   (const char *str, unsigned int length);
+    void write (void);                 // vide buf, sans condition
+
+    PrintBuffer (const PrintBuffer &);             // pas de copie
+    PrintBuffer & operator = (const PrintBuffer &);
+  };
+
+} // namespace ProcDebug
+
+#endif /* __PRINTBUFFER_H__ */
@@ -17,10 +17,19 @@
 #include <deque> 
 #include <string> 
 #include <map> 
+#include <algorithm> 
+
+#include "PrintBuffer.h"
+#include "InputFeed.h"
+#include "Device.h"
 
 namespace ProcDebug {
   
   class Scheduler; // car ProcInfo a un pointeur dessus
+  class Journal;   // idem, pour l'enregistrement et le rejeu
+  class MiniDbg;
+  class Checkpoint;
+  class OutputCapture; // --capture=
   // cette classe sera definie plus bas
   // 
   // elements du minilangage
@@ -130,6 +139,10 @@ namespace ProcDebug {
     // qui n'intervient pas du tout
 
 
+    friend class Scheduler; // pour le graphe d'attente
+    friend class MiniDbg;   // pour les watchpoints
+    friend class Checkpoint;
+
   public:    
     enum ProcStatus {
         STAT_WAITING, STAT_RUNNING, 
@@ -147,6 +160,55 @@ namespace ProcDebug {
       START_TRACE,
       END_TRACE,
     };
+    enum ProcExitCode { // comment un processus s'est termine
+        EXIT_NORMAL,    // ENDPROGRAM atteint
+        EXIT_ERROR,     // erreur a l'execution
+        EXIT_KILLED     // tue depuis le debugger
+    };
+    // ce qui reste d'un fils de FORK une fois libere : un par pid, pour
+    // le dernier processus qui a occupe ce pid
+    struct ProcExit {
+        unsigned int  generation; // nombre de processus liberes a ce pid
+        unsigned char exitCode;   // ProcExitCode
+        ProcExit() : generation(0), exitCode(EXIT_NORMAL) {}
+    };
+
+    // points de surveillance du debugger (watch) : une ecriture qui change
+    // une case surveillee est notee dans watchHit ; tant qu'une page de
+    // WATCH_PAGE cases n'a rien de surveille, writeSymbol() et
+    // writeMemory() n'en testent qu'un octet
+    enum WatchKind { WATCH_SYMBOL, WATCH_HEAP, WATCH_SHARED };
+    static const int WATCH_PAGE_SHIFT = 6; // 64 cases par page
+    struct WatchSet {
+        std::vector<unsigned char> pageCount; // cases surveillees par page
+        std::vector<int>           cells;     // triees
+        bool qWatched (const int cell) const;
+        bool add      (const int cell);       // faux si deja surveillee
+        bool remove   (const int cell);       // faux si pas surveillee
+    };
+    // xdiff : avant la premiere ecriture d'une page (meme taille que
+    // celles des watchpoints) depuis l'arret du debugger, son contenu
+    // est copie dans pages ; a l'arret suivant, ces copies passent dans
+    // lastPages, qui ne contient donc que les pages touchees entre les
+    // deux. une ecriture ne teste qu'un octet de saved
+    struct MemSnapshot {
+        std::vector<unsigned char>       saved;     // par page
+        std::map<int, std::vector<int> > pages;     // page -> contenu
+        std::map<int, std::vector<int> > lastPages; // a l'arret d'avant
+    };
+    struct MemChange {
+        bool qShared;
+        int  cell;      // dans heapMemory ou sharedMemory
+        int  oldValue, newValue;
+    };
+    struct WatchHit {
+        int         procPid;   // invalidProcPid : pas d'ecriture en attente
+        WatchKind   kind;
+        int         cell;
+        int         oldValue, newValue;
+        int         lineNumber;
+        std::string fileName;
+    };
     
   private:
     enum ProcInstructionType {
@@ -155,7 +217,8 @@ namespace ProcDebug {
         DO_READ, DO_PRINT, 
         DO_FORK, DO_MUTEX,
         DO_WHILEREPEAT, DO_PROGRAM, DO_NOTHING,
-        DO_SIGNAL, DO_SIGADD, DO_SIGDEL
+        DO_SIGNAL, DO_SIGADD, DO_SIGDEL,
+        DO_DEVREAD, DO_DEVWRITE
     };
     enum ProcAdvanceType {
         ADV_ONE_MORE_STEP_INSIDE, ADV_REACHED_END,
@@ -216,11 +279,61 @@ namespace ProcDebug {
         ProcInstruction *             father;   //DO_{WHILEREPEAT,PROGRAM}englb
         int                           lineNumber;//dans le fichier source
         std::string                   fileName;
+        // DO_PRINT, compile au parsing (voir ProcData::compilePrint()) :
+        // les chaines et nombres de l'instruction bout a bout, et ou y
+        // inserer la valeur de chaque variable
+        struct PrintHole { unsigned int textPos; int symbol; };
+        std::string                   printText;
+        std::vector<PrintHole>        printHoles;
+        bool                          qPrintNewLine; // '\n' dans printText
         ProcInstruction (ProcInstructionType t = DO_NOTHING,
                          ProcOperType opT = OP_NOP, 
                          const std::vector<int> &opNd = std::vector<int>());
         ProcInstruction (const ProcInstruction &);
+        ProcInstruction & operator = (const ProcInstruction &); // profonde
+        ~ProcInstruction();      // libere tout le sous-arbre bodyInstr
     }; // seront mises dans l'arbre proGram
+
+    // journal d'annulation d'un processus (reverse-step du debugger) :
+    // chaque pas commence par une marque UNDO_STEP (avec nextLineNumber),
+    // suivie du programCounter et du condEval des noeuds qu'il peut
+    // changer (le chemin de la racine a l'instruction courante), puis de
+    // l'ancienne valeur de chaque case qu'il ecrit. un anneau de taille
+    // fixe, alloue au premier pas : plein, il oublie son plus ancien pas
+    enum UndoKind { UNDO_STEP, UNDO_PC, UNDO_SYMBOL, UNDO_HEAP, UNDO_SHARED };
+    struct UndoEntry {
+        unsigned char     kind;      // UndoKind
+        unsigned char     condEval;  // UNDO_PC
+        int               cell;      // UNDO_PC : programCounter,
+                                     // UNDO_STEP : nextLineNumber
+        int               oldValue, newValue;
+        ProcInstruction * instr;     // UNDO_PC
+    };
+    struct UndoLog {
+        std::vector<UndoEntry> ring;
+        unsigned int           first;  // plus ancienne entree
+        unsigned int           count;
+        unsigned int           steps;  // marques UNDO_STEP dans l'anneau
+        UndoLog() : first(0), count(0), steps(0) {}
+        void push  (const UndoEntry &entry);
+        void clear () { first = count = steps = 0; }
+    };
+    
+    // table des lignes d'un programme, faite une fois au chargement :
+    // le texte de chaque ligne du fichier, et les instructions qui y
+    // commencent (celles que findCrtInstruction() peut rendre, donc ni
+    // PROGRAM ni le corps d'un SIGNAL) ; nextExec[k] est la premiere
+    // ligne executable a partir de k, -1 s'il n'y en a plus. le debugger
+    // s'en sert pour valider un breakpoint et pour "list", sans relire
+    // le fichier
+    struct LineTable {
+        std::vector<std::string>                       source;
+        std::vector<std::vector<ProcInstructionType> > instrs;
+        std::vector<int>                               nextExec;
+        bool qExecutable (const unsigned int line) const {
+            return line < instrs . size() && ! instrs[line] . empty();
+        }
+    };
     
     struct ProcData { // pour chaque programme/processus a simuler
         std::string                    progName; // nom du fichier
@@ -246,10 +359,25 @@ namespace ProcDebug {
         // les autres donnees-membres essentielles pour l'execution
         ProcStatus   procStatus,procMutexStatus;
         int          nextLineNumber;
+        bool         qProgress; // un pas a change une valeur, a signaler
+        // a l'ordonnanceur (voir ProcInfo::flushProgress())
+        bool         qReapable; // fils d'un FORK : libere des qu'il a
+        // termine (les programmes des fichiers restent, pour "start")
+        ProcExitCode exitCode;
+        unsigned char devState; // DevState : DEVREAD/DEVWRITE en cours
+        unsigned long stepCount; // instructions faites (0 a la naissance)
+        const std::vector<int> * traceLines; // du programme, 0 : aucun
+        // tracepoint (voir ProcInfo::tracePoints)
+        WatchSet     symbolWatch; // pas recopies par FORK : le debugger
+        WatchSet     heapWatch;   // surveille un processus donne
+        MemSnapshot  heapSnap;    // idem : un fils n'a pas d'arret d'avant
+        UndoLog      undoLog;     // pas recopie non plus : un fils de
+        // FORK ne peut pas revenir avant sa naissance
         // le constructeur et les methodes
         ProcData                  (const std::string &name = "<Anonymous>",
                                    int memL = 10000) ;
         ProcData                  (const ProcData &);
+        ~ProcData                 ();
         ProcInstruction *parseProg(const ProgToken &fileContent,
                                    unsigned int firstLine,
                                    unsigned int lastLine,
@@ -264,6 +392,11 @@ namespace ProcDebug {
         // dans l'arbre proGram, au bon endroit
         int findExistentSymbol    (const std::string&);
         int addNewSymbol          (const InstrToken &);
+        // le gabarit d'un PRINT, puis son texte avec les valeurs du
+        // moment, a partir de p (qui a la place de printMaxLength())
+        void         compilePrint   (ProcInstruction *);
+        unsigned int printMaxLength (const ProcInstruction *) const;
+        char *       fillPrint      (const ProcInstruction *, char *p) const;
     };
 
     // cette methode est appelee par updateProcData(), qui commande
@@ -287,12 +420,56 @@ namespace ProcDebug {
                                              bool *);   
     // puisqu'on a simplifie, et on a au plus une expression par 
     // instruction
-    void              doTerminateProc      (const int);
+    void              doTerminateProc      (const int,
+                                            const ProcExitCode = EXIT_NORMAL);
+    int               allocPid             ();
+    std::vector<int>  freePids;    // pids a reutiliser, pris par la fin
+    std::vector<int>  zombiePids;  // fils termines, pas encore liberes
+    int               zombieLock;  // un FORK fils peut terminer sur un
+    // thread de travail du moteur parallele
+
+    // toutes les ecritures de valeurs passent par ces deux methodes,
+    // ce qui permet de savoir si un pas a fait "progresser" l'etat
+    // (voir Scheduler::qAllBlocked())
+    void              writeSymbol          (const int, const int, const int);
+    void              writeMemory          (const int, const bool,
+                                            const int, const int);
+    int               readShared           (const int);
+    static bool       qIsSerialInstruction (const ProcInstructionType);
+    // l'arithmetique et les comparaisons du minilangage, partagees par
+    // doTheExpressionOfThe() et les conditions du debugger ; rend faux
+    // pour une division par zero (ou un operateur qui n'en est pas un)
+    static bool       applyOper            (const ProcOperType,
+                                            const int, const int, int *);
+    void              flushProgress        (const int);
+    void              snapshotCell         (const int, const bool,
+                                            const int);
+    void              snapshotPage         (MemSnapshot &,
+                                            const std::vector<int> &,
+                                            const unsigned int, const bool);
+    void              noteWatchHit         (const int, const WatchKind,
+                                            const int, const int, const int);
+    static unsigned int countInstructions  (const ProcInstruction *);
+    static bool       qHasInstruction      (const ProcInstruction *,
+                                            const ProcInstructionType);
+    typedef std::map<std::string, LineTable> LineTables;
+    LineTables        lineTables;  // par nom de fichier
+    static void       fillLineTable        (const ProcInstruction *,
+                                            LineTable *);
+    // le pas a faire, encadre par le journal d'annulation
+    void              doOneLoggedStep      (const int, ProcInstruction *);
+    void              logUndo              (const int, const UndoKind,
+                                            const int, const int, const int);
+    void              logUndoStep          (const int, ProcInstruction *);
+    static ProcInstruction *stepChild      (ProcInstruction *);
+    static bool       qIsIrreversible      (const ProcInstructionType);
     
   public:
     
     std::vector<ProcData *> procData;           // indexe par les pids des 
-    // programmes/processus a simuler
+    // programmes/processus a simuler ; 0 pour un pid libre (fils libere)
+    std::vector<ProcExit>   procExit;           // indexe par pid aussi
+    unsigned long           reapedCount;
     int                 outstandingProcCount; // decremente au fur et a
     // mesure que les processus terminent
     static const int ONE_INSTRUCTION_SLEEP = 1;
@@ -302,17 +479,180 @@ namespace ProcDebug {
     static const int MUTEX_OPER_P      = -1;
     static const int MUTEX_OPER_V      = -2;
     static const char * procStateStr[];
+    static const char * exitCodeStr[];  // indexe par ProcExitCode
     static const char * operChar[];
     static const char * instructionKeyword[];
     static const std::string inlineRegOper;
     static const int    invalidProcPid = -1;
     int                 mutex;     
+    int                 mutexOwner; // pid de celui qui a fait le P
+    // (invalidProcPid si le mutex est libre), pour le graphe d'attente
+    unsigned int        maxProgLength; // nombre d'instructions du plus
+    // long programme, qui borne la duree d'un tour de boucle d'attente
     std::vector<int>    sharedMemory;
     int                 sharedMemoryBase;
     int                 sharedMemoryLimit;
 
     Scheduler          *scheduler;
 
+    // expressions du debugger (print, display, break <ligne> if) : celles
+    // du minilangage, <operande> [<oper> <operande>], ou une operande est
+    // un nombre, une variable, <var>$<indice> (le tas, comme LOAD) ou
+    // _$<indice> (la memoire partagee), l'indice etant un nombre ou une
+    // variable. decoupees par tokenizeInstr() et resolues en indices dans
+    // symbolTable une fois pour toutes ; evalExpr() ne fait plus que le
+    // calcul, avec applyOper() comme doTheExpressionOfThe(), et rend faux
+    // pour une division par zero ou une case hors de la memoire
+    enum ExprOperandKind {
+        EXPR_NONE, EXPR_CONST, EXPR_SYMBOL, EXPR_HEAP, EXPR_SHARED
+    };
+    struct ExprOperand {
+        ExprOperandKind kind;
+        int  value;       // la constante, ou l'indice de la variable (la
+        // base pour EXPR_HEAP)
+        int  indexSlot;   // -1 : indexValue est une constante
+        int  indexValue;
+        ExprOperand() : kind(EXPR_NONE), value(0), indexSlot(-1),
+                        indexValue(0) {}
+    };
+    struct CompiledExpr {
+        ProcOperType operType;   // OP_NOP : left toute seule
+        ExprOperand  left, right;
+        CompiledExpr() : operType(OP_NOP) {}
+    };
+    // une condition vraie si l'expression ne vaut pas 0 ; vide (jamais
+    // compilee), toujours vraie. evalCond() rend aussi vrai si le calcul
+    // echoue, avec *pqFailed : le debugger s'arrete et le signale
+    typedef CompiledExpr CompiledCond;
+    bool  compileExpr (const int procPid, const std::string &text,
+                       CompiledExpr *pExpr, std::string *pErrMsg);
+    bool  evalExpr    (const int procPid, const CompiledExpr &expr,
+                       int *pValue) const;
+    bool  evalCond    (const int procPid, const CompiledCond &cond,
+                       bool *pqFailed) const;
+  private:
+    bool  compileOperand (const int procPid,
+                          const std::deque<InstrToken> &token,
+                          unsigned int *pPos, ExprOperand *pOperand,
+                          std::string *pErrMsg);
+    bool  evalOperand    (const int procPid, const ExprOperand &operand,
+                          int *pValue) const;
+  public:
+
+    // surveillance : cell est un indice dans symbolTable, heapMemory ou
+    // sharedMemory selon kind (procPid ne sert pas pour WATCH_SHARED) ;
+    // watchHit est lu, puis remis a invalidProcPid, par le debugger
+    WatchSet            sharedWatch;
+    unsigned int        watchCount;   // surveillances actives, en tout
+    WatchHit            watchHit;
+    bool  setWatch    (const int procPid, const WatchKind kind,
+                       const int cell, const bool qOn);
+
+    // les cases changees entre les deux derniers arrets du debugger (voir
+    // MemSnapshot) : markStop() a chaque arret, puis diffMemory() pour
+    // le tas de procPid et la memoire partagee, dans l'ordre des cases.
+    // rien n'est copie avant le premier arret
+    MemSnapshot         sharedSnap;
+    bool                qMemSnapshot; // vrai apres le premier markStop()
+    int                 snapLock;     // sharedSnap, en mode parallele
+    void  markStop    (void);
+    void  diffMemory  (const int procPid, std::vector<MemChange> *pChanges);
+
+    // tracepoints (trace <ligne> <var>...) : chaque fois qu'un processus
+    // du programme execute la ligne, son pid, son nombre de pas et la
+    // valeur des variables (apres l'instruction) vont dans un anneau
+    // alloue au premier tracepoint, sans arreter personne ; plein, il
+    // ecrase les plus anciens. le test d'une instruction ne coute qu'un
+    // pointeur nul tant que son programme n'a pas de tracepoint, puis une
+    // case de traceLines (indice du tracepoint + 1, par ligne). dumpTrace()
+    // ecrit ce qui a ete enregistre depuis la precedente et l'oublie
+    static const unsigned int TRACE_RING_SIZE = 1 << 16;
+    static const unsigned int TRACE_MAX_VARS  = 4;
+    struct TraceRecord {
+        int           procPid;
+        int           point;       // indice dans tracePoints
+        int           lineNumber;  // le tracepoint a pu etre supprime
+        unsigned long step;
+        int           values[TRACE_MAX_VARS];
+    };
+    struct TracePoint {
+        std::string              progName;
+        int                      lineNumber; // -1 : supprime
+        std::vector<std::string> names;
+        std::vector<int>         slots;      // dans symbolTable
+    };
+    std::vector<TracePoint>  tracePoints; // jamais raccourci : les
+    // enregistrements y renvoient
+    int   addTracePoint    (const int procPid, const int lineNumber,
+                            const std::vector<std::string> &names,
+                            std::string *pErrMsg);
+    bool  removeTracePoint (const unsigned int point);
+    void  dumpTrace        (std::ostream *s, const bool qMachine);
+    bool  qTraceLeft       (void) const { return traceNext != traceDumped; }
+  private:
+    std::map<std::string, std::vector<int> > traceLineMap; // par programme
+    std::vector<TraceRecord>  traceRing;
+    unsigned long             traceNext;   // enregistrements faits
+    unsigned long             traceDumped; // ... et deja ecrits
+    void  noteTrace        (const int procPid, const int lineNumber);
+  public:
+    Journal            *journal;   // 0 : ni enregistrement ni rejeu
+    PrintBuffer         output;    // la sortie des PRINT (--output=)
+    OutputCapture      *capture;   // 0 : les PRINT vont dans output
+    InputFeeds         *input;     // 0 : les READ lisent stdinLines
+
+    // READ asynchrone : un processus elu normalement (pas trace) qui n'a
+    // pas de ligne a lire reste sur son READ en STAT_IOWAIT, hors des
+    // files, comme un P qui echoue ; pollInput(), appelee par la boucle
+    // principale, lit ce qui est arrive et reveille autant d'entre eux
+    // qu'il y a de lignes (en attendant la suivante si plus personne ne
+    // peut tourner). a la fin de l'entree, un READ termine le processus
+    // en erreur. avec un journal, les READ restent synchrones : l'instant
+    // ou arrive une ligne ne se rejoue pas
+    StdinLines          stdinLines;
+    bool                qAsyncRead;
+    // l'attente de la ligne suivante, en ms (-1 : sans limite) ; le
+    // debugger non-stop sur socket doit etre servi entre-temps
+    int                 inputIdleWait;
+    static const int    DBG_INPUT_WAIT = 50;
+    std::deque<int>     ioWaitPids;    // peut contenir des pids reveilles
+    // autrement (debugger) : seul STAT_IOWAIT compte
+    static const unsigned int INPUT_POLL_TICKS = 64; // un poll() sur 64
+    // ticks, tant que d'autres tournent
+    void  pollInput   (const bool qIdle);
+    bool  qInputWait  (void) const; // quelqu'un attend vraiment une ligne
+    // un READ du programme (ou de son traitant) peut lire l'entree
+    // standard : pas de source --input=, ou un fichier, qui s'epuise
+    bool  qReadsStdin (const int procPid) const;
+
+    // le peripherique de DEVREAD/DEVWRITE (voir Device.h) : un processus
+    // elu normalement y depose sa requete et attend en STAT_IOWAIT, hors
+    // des files ; completeDeviceIo(), appelee a chaque tick par la boucle
+    // principale, reveille ceux dont la requete est finie, qui refont
+    // alors l'instruction et font le transfert. trace par le debugger,
+    // le transfert est immediat
+    enum DevState { DEV_IDLE, DEV_PENDING, DEV_DONE };
+    Device              device;
+    void  completeDeviceIo (void);
+
+    // reverse-step : undoStep() defait le dernier pas journalise du
+    // processus ; elle rend faux (avec la raison) s'il n'y en a plus, ou
+    // si une case partagee qu'il a ecrite a change depuis. les entrees/
+    // sorties, FORK, MUTEX, SIGADD/SIGDEL et la terminaison ne se
+    // defont pas : ils vident le journal du processus
+    static const unsigned int DEFAULT_UNDO_LOG_SIZE = 1024;
+    unsigned int        undoLogSize;  // entrees par processus, 0 : aucun
+    bool  undoStep      (const int procPid, std::string *pErrMsg);
+    unsigned int undoStepCount (const int procPid) const {
+        return procData[procPid] -> undoLog . steps;
+    }
+    void  forgetUndo    (const int procPid) {
+        procData[procPid] -> undoLog . clear();
+    }
+
+    // 0 si le programme n'a pas ete charge depuis un fichier
+    const LineTable * findLineTable (const std::string &progName) const;
+
     ProcInfo(const std::string &, 
              bool qMnSV = false, bool qTokV = false, 
              bool qPrsV = false, bool qExecV = false); 
@@ -327,6 +667,10 @@ namespace ProcDebug {
     bool  qExecutingVerbose;
     void   displayProcInfo   (std::ostream *, const int, bool qDump = false);
     void   dumpProcInfoStat  (std::ostream *)    const;
+    // libere les fils termines, sauf les deux pids donnes (celui que
+    // suit le debugger et le dernier elu, que le traitant de SIGQUIT
+    // utilise) et celui qui garde le mutex ; appelee entre deux ticks
+    void   reapZombies       (const int keptPid1, const int keptPid2);
     std::string getProcName  (const int procPid) const;
     int    updateProcData    (const int procPid, 
                               const ProcInfoOperType  p,
@@ -338,24 +682,112 @@ namespace ProcDebug {
     void       avancerDUnPas (const int procPid,
                               ProcInstruction * progAAvancer = NULL);
 
+    // plusieurs pas du processus trace, d'un coup, pour le debugger :
+    //   STEP_COUNT  : arg pas
+    //   STEP_OVER   : un pas, ou, sur un WHILE, jusqu'a en etre sorti
+    //   STEP_FINISH : jusqu'a la sortie du WHILE qui englobe l'instruction
+    //                 courante (STOP_NOLOOP s'il n'y en a pas)
+    //   STEP_UNTIL  : jusqu'a la ligne arg
+    // on s'arrete avant sur une ecriture surveillee (watchHit), sur la
+    // terminaison, ou sur une ligne marquee dans pStopLines dont la
+    // condition est vraie (les breakpoints), ou ne peut etre calculee
+    // (STOP_CONDERROR) ; STOP_INTERRUPT si une autre
+    // session du debugger a detrace le processus entre-temps (SIGQUIT
+    // est debloque tous les STEP_SIGNAL_PERIOD pas). *pSteps : les pas faits
+    enum StepMode { STEP_COUNT, STEP_OVER, STEP_FINISH, STEP_UNTIL };
+    enum StepStop { STOP_DONE, STOP_BREAK, STOP_CONDERROR, STOP_WATCH,
+                    STOP_EXIT, STOP_NOLOOP, STOP_INTERRUPT };
+    static const unsigned long STEP_SIGNAL_PERIOD = 1024;
+    StepStop   stepTraced    (const int procPid, const StepMode mode,
+                              const unsigned long arg,
+                              const std::vector<bool>         *pStopLines,
+                              const std::vector<CompiledCond> *pStopConds,
+                              unsigned long *pSteps);
+
+    // pour le moteur parallele (ParEngine) : runQuantum() peut etre
+    // appelee depuis un thread de travail, pour des processus distincts
+    // en meme temps ; elle avance d'au plus maxSteps pas et s'arrete
+    // avant une instruction qui doit etre faite par le thread principal
+    // (*pQSerial est alors vrai) ; finishQuantum(), appelee ensuite par le
+    // thread principal, remet le processus dans une file
+    bool  qParallel; // la memoire partagee passe alors par des atomiques
+    int   runQuantum    (const int procPid, const int maxSteps,
+                         bool *pQSerial);
+    void  finishQuantum (const int procPid, const int steps,
+                         const bool qSerial);
+
   }; // class ProcInfo
   
   class Scheduler {
+    friend class Checkpoint;
   public:
     Scheduler(ProcInfo   *pI  = 0, bool qSchV = false);
 
   private:
     ProcInfo   *pInfo;
-    std::deque<int>               waitQueue;
+    std::vector<std::deque<int> > waitQueue; // une file par CPU simule
     std::vector<std::deque<int> > mLevelQueue;
+
+    // mode SMP : chaque CPU simule elit son processus dans sa file a
+    // chaque tick ; avec un seul CPU on retrouve exactement le
+    // tourniquet d'origine
+    struct CpuStat {
+        unsigned long busyTicks, idleTicks, steals;
+        CpuStat() : busyTicks(0), idleTicks(0), steals(0) {}
+    };
+    struct ProcAffinity {
+        int           cpu;        // dernier CPU qui l'a elu, -1 sinon
+        int           migrations; // changements de CPU
+        unsigned long lastTick;   // pour ne pas l'elire deux fois par tick
+        ProcAffinity() : cpu(-1), migrations(0), lastTick(0) {}
+    };
+    std::vector<CpuStat>           cpuStat;
+    std::vector<ProcAffinity>      procAffinity;
+    unsigned long                  tickCount;
+
+    int  stealAProc    (const int cpu);
+    int  pickAProc     (const int cpu);
+    void takeReplayedProc (const int cpu, const int procPid);
+    ProcAffinity & affinityOf(const int procPid);
   public:
     void enQueueProc   (const int procPid);
     void enQueueAllProc();
     void displayQueue  (std::ostream *s);
     bool qSchedulingVerbose;
     
-    int electAProc     ();
+    int electAProc     (const int cpu = 0);
+
+    void setCpuCount   (const int nbCpu);
+    void forgetProc    (const int procPid); // pid libere, bientot reutilise
+    int  getCpuCount   () const;
+    bool qIdle         () const; // toutes les files sont vides
+    unsigned long getTick () const { return tickCount; }
+    void nextTick      (); // a chaque tour de tous les CPUs
+    void dumpStat      (std::ostream *s);
+
+    // detection d'interblocage : ProcInfo signale chaque pas execute,
+    // chaque pas qui a change une valeur (ou l'etat d'un processus), et
+    // chaque entree/sortie de STAT_MUTEXWAIT ; qAllBlocked() est en O(1)
+    // tant qu'elle rend faux. un processus qui tourne (pas en attente du
+    // mutex) avec un traitant et un signal (autre que SIGQUIT) dans son
+    // masque n'est jamais bloque : le signal peut encore arriver et lever
+    // son attente
+    void noteStep      ();
+    void noteSteps     (const unsigned long nbSteps);
+    void noteProgress  ();
+    void noteMutexWait (const int delta);
+    bool qAllBlocked   () const;
+    void dumpWaitForGraph(std::ostream *s);
 
+    // un processus qui boucle sans rien ecrire fait au plus
+    // maxProgLength + 1 pas par tour ; on laisse a chacun ce nombre
+    // de tours avant de conclure, pour absorber l'aleatoire du tourniquet
+    static const unsigned int DEADLOCK_ROUNDS = 4;
+
+  private:
+    unsigned long stepsSinceProgress;
+    int           mutexWaitCount;
+    bool qSignalCanWake () const;
   };
 
 
@@ -373,7 +805,7 @@ namespace ProcDebug {
      const std::vector<int> & opNd /* = just the empty one */) :  
         instructionType (t), operType (opT), operand (opNd), 
         leftValue (-1), condEval(COND_NOT_EVAL), programCounter (-1),
-        father(0), lineNumber(-1)
+        father(0), lineNumber(-1), qPrintNewLine(false)
     {}
     
     inline ProcInfo::ProcData::ProcData(const std::string &name, int memL):
@@ -385,15 +817,77 @@ namespace ProcDebug {
         heapMemoryLimit    (memL),
         procStatus         (STAT_WAITING), 
         procMutexStatus    (STAT_NOMUTEX),
-        nextLineNumber     (1) {
+        nextLineNumber     (1),
+        qProgress          (false),
+        qReapable          (false),
+        exitCode           (EXIT_NORMAL),
+        devState           (DEV_IDLE),
+        stepCount          (0),
+        traceLines         (0) {
         heapMemory . resize(heapMemoryLimit); // on pourrait optimiser, en 
         // retardant ceci, pour le faire graduellement dans
         // doTheInstruction(), lors d'un STORE qui depasserait... enfin bref.
     }
     
+    inline bool ProcInfo::WatchSet::qWatched(const int cell) const {
+        const unsigned int page (cell >> WATCH_PAGE_SHIFT);
+        return page < pageCount . size() && pageCount[page] &&
+            std::binary_search(cells . begin(), cells . end(), cell);
+    }
+
+    inline bool ProcInfo::applyOper(const ProcOperType op,
+                                    const int a, const int b, int *pResult) {
+        switch(op) {
+            case OP_ADD:  *pResult = a +  b; return true;
+            case OP_SUB:  *pResult = a -  b; return true;
+            case OP_MUL:  *pResult = a *  b; return true;
+            case OP_DIV:  if(!b) return false; *pResult = a / b; return true;
+            case OP_REM:  if(!b) return false; *pResult = a % b; return true;
+            case OP_GT:   *pResult = a >  b; return true;
+            case OP_LT:   *pResult = a <  b; return true;
+            case OP_GE:   *pResult = a >= b; return true;
+            case OP_LE:   *pResult = a <= b; return true;
+            case OP_EQ:   *pResult = a == b; return true;
+            case OP_DIFF: *pResult = a != b; return true;
+            default:      return false;
+        }
+    }
+
+    // une division par zero dans la condition : on s'arrete quand meme,
+    // sinon le breakpoint ne se declencherait jamais sans rien dire
+
+    inline bool ProcInfo::evalCond(const int procPid,
+                                   const CompiledCond &cond,
+                                   bool *pqFailed) const {
+        *pqFailed = false;
+        if(cond . left . kind == EXPR_NONE) return true;
+        int result;
+        if(!evalExpr(procPid, cond, &result)) {
+            *pqFailed = true;
+            return true;
+        }
+        return result;
+    }
+
     inline Scheduler::Scheduler(ProcInfo   *pI /* = 0*/,
                                 bool qSchV  /* = false*/) :
-        pInfo (pI), qSchedulingVerbose(qSchV) {}    
+        pInfo (pI), tickCount (1), qSchedulingVerbose(qSchV),
+        stepsSinceProgress (0), mutexWaitCount (0) {
+        setCpuCount(1);
+    }
+
+    inline int  Scheduler::getCpuCount() const { return waitQueue . size(); }
+    inline void Scheduler::nextTick   () { ++tickCount; }
+
+    inline void Scheduler::noteStep     () { ++stepsSinceProgress; }
+    inline void Scheduler::noteSteps    (const unsigned long nbSteps) {
+        stepsSinceProgress += nbSteps;
+    }
+    inline void Scheduler::noteProgress () { stepsSinceProgress = 0; }
+    inline void Scheduler::noteMutexWait(const int delta) {
+        // peut venir d'un thread de travail (moteur parallele)
+        __sync_fetch_and_add(&mutexWaitCount, delta);
+    }
 }
 
 #endif /*  __PROCDEBUG_H__ */
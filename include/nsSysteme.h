@@ -18,6 +18,7 @@
 #include <sys/stat.h>     // struct stat, stat(), fstat()
 #include <signal.h>       // struct sigaction, sigaction(), sigset_t
 #include <sys/wait.h>    //waitpid()
+#include <sys/mman.h>    // mmap(), munmap()
 
 #include "string.h"      
 
@@ -63,6 +64,12 @@ namespace nsSysteme
     ::off_t     Lseek (int fildes, ::off_t offset, int whence)
     				throw (CExc); 
 
+    void *      Mmap   (void * start, std::size_t length, int prot,
+                        int flags, int fd, ::off_t offset)
+                             throw (CExc);
+    void        Munmap (void * start, std::size_t length)
+                             throw (CExc);
+
 
 
    
@@ -284,6 +291,26 @@ inline ::off_t nsSysteme::Lseek (int fildes, ::off_t offset, int whence)
 
 } // Lseek() 
 
+inline void * nsSysteme::Mmap (void * start, std::size_t length, int prot,
+                               int flags, int fd, ::off_t offset)
+    throw (CExc)
+{
+    void * Res;
+    if (MAP_FAILED == (Res = ::mmap (start, length, prot, flags, fd, offset)))
+        throw CExc ("mmap()", fd);
+
+    return Res;
+
+} // Mmap()
+
+inline void nsSysteme::Munmap (void * start, std::size_t length)
+    throw (CExc)
+{
+    if (::munmap (start, length))
+        throw CExc ("munmap()", "");
+
+} // Munmap()
+
 
 
 